@@ -0,0 +1,21 @@
+#ifndef ANMS_H
+#define ANMS_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <vector>
+
+std::vector<cv::KeyPoint> anms_grid_filter(const std::vector<cv::KeyPoint> &keypoints,
+                                           const cv::Size &image_size,
+                                           int max_keypoints,
+                                           int grid_cols = 8,
+                                           int grid_rows = 6);
+
+bool detect_and_compute_uniform(const cv::Ptr<cv::Feature2D> &detector,
+                                const cv::Mat &image,
+                                const cv::Mat &mask,
+                                int max_keypoints,
+                                std::vector<cv::KeyPoint> &keypoints,
+                                cv::Mat &descriptors);
+
+#endif // ANMS_H
@@ -0,0 +1,57 @@
+#ifndef BLEND_H
+#define BLEND_H
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+#include "pixel_kernels.h"
+
+// 定点权重的满值，权重 w 表示图像 2 占 w / 256
+#define BLEND_WEIGHT_ONE 256
+
+void build_feather_ramp(int width, bool img2_on_right, std::vector<ushort> &ramp);
+
+void find_seam(const cv::Mat &img1, const cv::Mat &img2, const cv::Mat &mask2, std::vector<int> &seam);
+
+void build_seam_ramp(int width, int band, bool img2_on_right, std::vector<ushort> &ramp);
+
+void seam_blend_span(const PixelRowKernels &kernels, const uchar *src2, const uchar *mask2, uchar *dst,
+                     int x_begin, int x_end, int seam_x, int width, int band, bool img2_on_right,
+                     const std::vector<ushort> &ramp, const uchar *lut2, uchar *scratch);
+
+bool overlap_channel_means(const cv::Mat &img1, const cv::Mat &img2, const cv::Mat &mask2, int step,
+                           cv::Vec3d &mean1, cv::Vec3d &mean2);
+
+void build_gain_lut(const cv::Vec3f &gain, int channels, cv::Mat &lut);
+
+bool update_gain_lut(const cv::Vec3f &gain, int channels, cv::Vec3f &lut_gain, cv::Mat &lut);
+
+/**
+ * Multi-band (Laplacian pyramid) blender restricted to one region.
+ *
+ * The pyramids only cover the region passed to blend(), normally the overlap rectangle,
+ * so the cost is bounded by the overlap area. All pyramid buffers are kept between
+ * calls and only reallocated when the region size changes.
+ */
+class PyramidBlender {
+public:
+    explicit PyramidBlender(int num_bands = 5);
+
+    void set_mask(const cv::Mat &mask2);
+    bool empty() const { return weight_pyr_.empty(); }
+    cv::Size size() const { return empty() ? cv::Size() : weight_pyr_[0].size(); }
+
+    void blend(const cv::Mat &img1, const cv::Mat &img2, cv::Mat &dst);
+
+private:
+    void build_laplacian(const cv::Mat &src, std::vector<cv::Mat> &pyr);
+
+    int num_bands_;
+    std::vector<cv::Mat> weight_pyr_;  // 图像 2 权重的高斯金字塔，CV_32F
+    std::vector<cv::Mat> lap1_;        // 拉普拉斯金字塔，CV_32F，通道数同输入
+    std::vector<cv::Mat> lap2_;
+    std::vector<cv::Mat> blurred_;     // 每层下采样前的模糊缓冲
+    std::vector<cv::Mat> expanded_;    // 每层的上采样缓冲
+};
+
+#endif // BLEND_H
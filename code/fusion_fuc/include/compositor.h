@@ -0,0 +1,21 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include "stitcher.h"
+
+// 图块类型，标定后确定，每帧按类型走不同的路径
+enum TileType {
+    TILE_EMPTY,   // 两幅图都不覆盖，填零
+    TILE_IMG1,    // 只有图像 1：查表拷贝
+    TILE_IMG2,    // 只有图像 2：直接透视变换到输出
+    TILE_BLEND    // 两幅图都参与：拷贝、变换、接缝混合
+};
+
+cv::Mat region_homography(const FusionCalibration &calibration, const cv::Rect &region);
+
+void classify_tiles(FusionCalibration &calibration);
+
+void composite_tiles(const cv::Mat &img1, const cv::Mat &img2, const FusionCalibration &calibration,
+                     const cv::Mat &blended_overlap, AVFrame *frame);
+
+#endif // COMPOSITOR_H
@@ -0,0 +1,18 @@
+#ifndef FUSION_PARAMS_H
+#define FUSION_PARAMS_H
+
+// 两图拼接（stitcher.cpp）和 N 相机全景（panorama.cpp）共用的调优参数，两条路径保持一致
+
+// 接缝两侧羽化窄带的宽度（像素）
+static const int FUSION_SEAM_BAND = 32;
+
+// 增益补偿：每帧刷新时的抽样步长、平滑系数和增益范围
+static const int FUSION_GAIN_STEP = 8;
+static const float FUSION_GAIN_ALPHA = 0.1f;
+static const float FUSION_GAIN_MIN = 0.5f;
+static const float FUSION_GAIN_MAX = 2.0f;
+
+// 画布面积相对所有输入面积之和的上限，超过说明单应矩阵退化
+static const double FUSION_MAX_CANVAS_RATIO = 4.0;
+
+#endif // FUSION_PARAMS_H
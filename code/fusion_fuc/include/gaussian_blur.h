@@ -0,0 +1,39 @@
+#ifndef GAUSSIAN_BLUR_H
+#define GAUSSIAN_BLUR_H
+
+#include <opencv2/core.hpp>
+#include <map>
+#include <mutex>
+
+// sigma 不小于该值时改用递归 (IIR) 滤波，每像素代价与 sigma 无关
+#define GAUSSIAN_IIR_SIGMA 4.0
+
+/**
+ * Shared Gaussian blur service.
+ *
+ * Small sigmas use a separable convolution with 1D kernels cached per sigma; large sigmas
+ * use the Young–van Vliet recursive filter. Used by the scale-space builders and the
+ * blending pyramid.
+ */
+class GaussianBlurService {
+public:
+    static GaussianBlurService &instance();
+
+    const cv::Mat &kernel(double sigma);
+
+    void blur(const cv::Mat &src, cv::Mat &dst, double sigma);
+
+private:
+    GaussianBlurService() = default;
+
+    void blur_separable(const cv::Mat &src, cv::Mat &dst, double sigma);
+    void blur_recursive(const cv::Mat &src, cv::Mat &dst, double sigma);
+
+    std::mutex mutex_;
+    std::map<int, cv::Mat> kernels_;  // key: sigma * 1000 取整
+};
+
+// 便捷接口，等价于 GaussianBlurService::instance().blur()
+void gaussian_blur(const cv::Mat &src, cv::Mat &dst, double sigma);
+
+#endif // GAUSSIAN_BLUR_H
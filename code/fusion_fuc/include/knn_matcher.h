@@ -0,0 +1,42 @@
+#ifndef KNN_MATCHER_H
+#define KNN_MATCHER_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <vector>
+
+/**
+ * Reusable kNN matcher for float descriptors (SIFT).
+ *
+ * The train descriptors are quantized to int8 once in train(); queries are quantized with
+ * the same scale and scored with SIMD int8 dot products, using
+ * |a - b|^2 = |a|^2 + |b|^2 - 2 a·b. For a static camera the index is trained once and
+ * queried for every frame.
+ */
+class QuantizedKnnMatcher {
+public:
+    QuantizedKnnMatcher() = default;
+
+    bool train(const cv::Mat &descriptors);
+    bool empty() const { return train_q_.empty(); }
+    int size() const { return train_q_.rows; }
+
+    void knn_match(const cv::Mat &query,
+                   std::vector<std::vector<cv::DMatch>> &matches,
+                   int k = 2) const;
+
+    void ratio_match(const cv::Mat &query,
+                     std::vector<cv::DMatch> &matches,
+                     float ratio = 0.7f) const;
+
+private:
+    void quantize(const cv::Mat &src, cv::Mat &dst, std::vector<int> &norms) const;
+
+    cv::Mat train_q_;               // CV_8S, 每行一个量化后的描述子
+    std::vector<int> train_norms_;  // 量化描述子的平方范数
+    float scale_ = 1.0f;            // 浮点值 -> int8 的缩放系数
+};
+
+bool hamming_cross_match(const cv::Mat &query, const cv::Mat &train, std::vector<cv::DMatch> &matches);
+
+#endif // KNN_MATCHER_H
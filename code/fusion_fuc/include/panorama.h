@@ -0,0 +1,77 @@
+#ifndef PANORAMA_H
+#define PANORAMA_H
+
+#include "stitcher.h"
+#include "warp_maps.h"
+
+// 多相机标定方式
+enum PanoramaCalibrationMode {
+    PANORAMA_CALIB_PAIRWISE,  // 相邻相机两两估计单应矩阵，沿链路传递到参考相机
+    PANORAMA_CALIB_GLOBAL     // 在链路结果上，用所有可匹配的相机对联合优化全部单应矩阵
+};
+
+// 全景画布的投影面
+enum PanoramaProjection {
+    PANORAMA_PROJECTION_PLANE,        // 参考相机的像平面，视场超过约 100° 时边缘拉伸严重
+    PANORAMA_PROJECTION_CYLINDRICAL,  // 竖直轴圆柱面，横向视场可到 360°（不含）
+    PANORAMA_PROJECTION_SPHERICAL     // 经纬度球面，横向视场可到 360°（不含），纵向不受限
+};
+
+// 一个相机在全景画布上的几何与每帧缓冲
+struct PanoramaCamera {
+    cv::Size input_size;         // 标定时的输入尺寸
+    cv::Mat homography;          // 相机 -> 参考相机坐标
+    cv::Matx33d intrinsics;      // 相机内参 K，曲面投影时使用
+    cv::Matx33d rotation;        // 相机 -> 参考相机的旋转，曲面投影时使用
+    cv::Rect rect;               // 投影在画布上的外接矩形
+    WarpMaps maps;               // rect 局部坐标 -> 相机像素的定点映射及有效区域
+    cv::Vec3f gain = cv::Vec3f(1, 1, 1);
+    cv::Mat gain_lut;            // 1x256 查找表，通道数同画布
+    cv::Vec3f lut_gain;          // 查找表建立时的增益，增益明显变化时才重建
+    cv::Mat warped;              // 每帧的变换结果，rect 局部坐标，跨帧复用
+};
+
+// 相邻两相机之间的接缝：second 先写入画布，first 再沿接缝混入
+struct PanoramaSeam {
+    int first = 0;
+    int second = 0;
+    cv::Rect overlap_rect;       // 两相机 rect 的交集，画布坐标
+    cv::Mat mask;                // 两相机都有效的区域，重叠区坐标
+    bool first_on_right = false; // first 是否位于 second 右侧
+    std::vector<int> seam;       // 每行的接缝列，重叠区坐标
+    std::vector<ushort> ramp;    // 见 build_seam_ramp()
+};
+
+/**
+ * Geometry shared by every frame of one multi-camera calibration.
+ *
+ * Cameras are expected in rig order, so that neighbouring indices overlap. All cameras
+ * are mapped into the frame of the reference camera; the canvas is the union of their
+ * projections, translated so that nothing lands at negative coordinates.
+ */
+struct PanoramaCalibration {
+    bool valid = false;
+    cv::Size canvas_size;
+    std::vector<PanoramaCamera> cameras;
+    std::vector<PanoramaSeam> seams;
+    int seam_band = 0;
+    const PixelRowKernels *row_kernels = nullptr;  // 画布像素布局的行内核，标定时按输出格式取定
+    double scale = 0;            // 曲面投影时画布上每弧度的像素数
+
+    // 由调用方设置，重新标定时保留
+    PanoramaCalibrationMode mode = PANORAMA_CALIB_PAIRWISE;
+    FusionMotionModel motion_model = FUSION_MODEL_HOMOGRAPHY;  // 旋转模型需要设置 focal
+    PanoramaProjection projection = PANORAMA_PROJECTION_PLANE;
+    double focal = 0;            // 焦距（像素）；单应模型下为 0 表示由单应矩阵估计
+    int reference = -1;          // 参考相机下标，-1 表示取中间的相机
+    bool gain_compensation = true;
+    AVPixelFormat output_format = AV_PIX_FMT_BGR24;  // 输出帧格式，见 output_pixel_layout()
+};
+
+bool calibrate_panorama(const std::vector<cv::Mat> &images, PanoramaCalibration &calibration,
+                        const std::vector<cv::Mat> &raw_images = std::vector<cv::Mat>());
+
+bool panorama_fusion(const std::vector<AVFrame *> &frames, AVFrame *frame_fused, bool is_correct,
+                     PanoramaCalibration *calibration = nullptr);
+
+#endif // PANORAMA_H
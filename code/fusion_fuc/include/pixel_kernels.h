@@ -0,0 +1,65 @@
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+
+// 本头文件只用基本类型、不含内联函数：各指令集版本的翻译单元以不同的编译选项包含它，
+// 不能引入会在链接时被合并的内联代码
+
+// 画布的像素布局，由输出格式决定：GRAY8、BGR24、BGRA 帧直接写入，YUV420P、NV12 先按 BGR24 合成再转换
+enum PixelLayout {
+    PIXEL_LAYOUT_GRAY8,   // 1 通道
+    PIXEL_LAYOUT_BGR24,   // 3 通道交错
+    PIXEL_LAYOUT_BGRA32,  // 4 通道交错
+    PIXEL_LAYOUT_COUNT
+};
+
+// dst = (src1 * (256 - w) + src2 * w + 128) >> 8，w 为 ramp[x]；带掩码的版本在 mask2 为 0 处取 w = 0
+typedef void (*FeatherBlendRowFn)(const unsigned char *src1, const unsigned char *src2, const unsigned char *mask2,
+                                  const unsigned short *ramp, unsigned char *dst, int width);
+
+// 拷贝一行像素；带掩码的版本只写 mask 非 0 的像素，带查表的版本经 channels * 256 字节的逐通道交错表
+typedef void (*CopyRowFn)(const unsigned char *src, const unsigned char *mask, const unsigned char *lut,
+                          unsigned char *dst, int width);
+
+/**
+ * Row kernels of one pixel layout.
+ *
+ * Every entry is a separate instantiation for a fixed channel count and a fixed mode
+ * (with or without validity mask, with or without lookup table), so channel loops are
+ * unrolled and the inner loops carry no per-pixel branches. Callers pick the entries
+ * once, outside their pixel loops; parameters a mode does not use are ignored.
+ */
+struct PixelRowKernels {
+    int channels;
+    FeatherBlendRowFn feather_blend[2];  // 下标：[有掩码]
+    CopyRowFn copy[2][2];                // 下标：[有掩码][有查找表]
+};
+
+/**
+ * One instruction-set variant of the per-pixel hot loops.
+ *
+ * Every variant computes bit-identical results; they only differ in the instructions the
+ * compiler was allowed to use. The variant is chosen once, when the library is loaded.
+ */
+struct PixelKernels {
+    const char *name;
+    PixelRowKernels rows[PIXEL_LAYOUT_COUNT];
+    void (*bgr_to_yuv420_rows)(const unsigned char *bgr0, const unsigned char *bgr1, int width,
+                               unsigned char *y0, unsigned char *y1, unsigned char *u, unsigned char *v,
+                               int uv_step);
+    int (*dot_int8)(const signed char *a, const signed char *b, int len);
+    int (*hamming_u8)(const unsigned char *a, const unsigned char *b, int len);  // 二进制描述子的汉明距离
+};
+
+// 通用版本：OpenCV 通用 intrinsics，按编译基线生成（x86-64 上为 SSE2）
+namespace pixel_baseline { extern const PixelKernels kernels; }
+
+// x86 版本：同一份可移植源码 pixel_kernels.inl 分别以 SSE4.2、AVX2、AVX-512 选项编译
+namespace pixel_sse42 { extern const PixelKernels kernels; }
+namespace pixel_avx2 { extern const PixelKernels kernels; }
+namespace pixel_avx512 { extern const PixelKernels kernels; }
+
+const PixelKernels &pixel_kernels();
+
+const PixelRowKernels &pixel_row_kernels(PixelLayout layout);
+
+#endif // PIXEL_KERNELS_H
@@ -0,0 +1,13 @@
+#ifndef ROTATION_MODEL_H
+#define ROTATION_MODEL_H
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+cv::Matx33d camera_intrinsics(double focal, const cv::Size &size);
+
+bool estimate_rotation(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
+                       const cv::Matx33d &k1, const cv::Matx33d &k2, double threshold,
+                       cv::Matx33d &rotation, std::vector<uchar> &inlier_mask);
+
+#endif // ROTATION_MODEL_H
@@ -8,6 +8,8 @@
 #include <chrono>
 #include <opencv2/calib3d.hpp>
 #include <opencv2/opencv.hpp>
+#include <memory>
+#include "blend.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -26,6 +28,96 @@ AVFrame *cvmatToAvframe(const cv::Mat *image, AVFrame *frame);
 
 bool correct_image(AVFrame *frame_input, AVFrame *frame_output);
 
-bool image_fusion(AVFrame *frame1, AVFrame *frame2, AVFrame *frame_fused, bool is_correct);
+cv::Mat correct_lens(const cv::Mat &image);
+
+cv::Size lens_corrected_size(const cv::Size &size);
+
+void undistort_points(const std::vector<cv::Point2f> &points, const cv::Size &size,
+                      std::vector<cv::Point2f> &undistorted);
+
+cv::Mat frame_to_image(AVFrame *frame, bool is_correct);
+
+bool prepare_output_frame(AVFrame *frame, const cv::Size &size, AVPixelFormat format);
+
+bool output_pixel_layout(AVPixelFormat format, PixelLayout &layout);
+
+cv::Mat to_pixel_layout(const cv::Mat &bgr, int channels);
+
+
+// 标定时拟合的相机间运动模型
+enum FusionMotionModel {
+    FUSION_MODEL_HOMOGRAPHY,  // 8 自由度单应矩阵
+    FUSION_MODEL_ROTATION     // 共光心、已知焦距的 3 自由度旋转，两点最小样本
+};
+
+bool match_keypoints(const cv::Mat &img1, const cv::Mat &img2,
+                     std::vector<cv::Point2f> &points1, std::vector<cv::Point2f> &points2);
+
+bool estimate_homography(const cv::Mat &img1, const cv::Mat &img2, cv::Mat &homography,
+                         std::vector<cv::Point2f> *inliers1 = nullptr,
+                         std::vector<cv::Point2f> *inliers2 = nullptr,
+                         FusionMotionModel model = FUSION_MODEL_HOMOGRAPHY, double focal = 0,
+                         bool raw_input = false);
+
+// 重叠区域的融合方式
+enum FusionBlendMode {
+    FUSION_BLEND_FEATHER,    // 沿接缝两侧窄带内的定点线性羽化
+    FUSION_BLEND_MULTIBAND   // 只在重叠区域内做的多频段（拉普拉斯金字塔）融合
+};
+
+/**
+ * Geometry shared by every frame of one calibration.
+ *
+ * All rectangles are in canvas coordinates. The canvas is the union of img1 and the
+ * projected corners of img2, translated so that nothing lands at negative coordinates.
+ */
+struct FusionCalibration {
+    bool valid = false;
+    cv::Size input_size1;        // 标定时的输入尺寸，尺寸变化时需重新标定
+    cv::Size input_size2;
+    cv::Mat homography;          // 图像 2 -> 图像 1 坐标
+    cv::Mat warp_homography;     // 图像 2 -> warp_rect 局部坐标
+    cv::Size canvas_size;
+    cv::Rect img1_rect;          // 图像 1 在画布上的位置
+    cv::Rect warp_rect;          // 图像 2 投影的外接矩形
+    cv::Rect overlap_rect;       // img1_rect 与 warp_rect 的交集
+    cv::Mat warp_mask;           // 图像 2 的有效区域，warp_rect 局部坐标，CV_8UC1
+    bool img2_on_right = true;   // 图像 2 是否位于图像 1 右侧
+    std::vector<int> seam;       // 重叠区每行的接缝列，重叠区坐标
+    std::vector<ushort> seam_ramp;  // 接缝窄带的定点权重表，见 build_seam_ramp()
+    int seam_band = 0;           // 接缝两侧羽化窄带的宽度
+    const PixelRowKernels *row_kernels = nullptr;  // 画布像素布局的行内核，标定时按输出格式取定
+    cv::Mat blend_mask;          // 多频段融合的分界，重叠区坐标，255 处取图像 2
+
+    // 逐相机逐通道增益：标定时用重叠区估计，之后每帧用抽样统计平滑刷新
+    cv::Vec3f gain1 = cv::Vec3f(1, 1, 1);
+    cv::Vec3f gain2 = cv::Vec3f(1, 1, 1);
+    cv::Mat gain_lut1;           // 1x256 查找表，通道数同画布，在拷贝/混合时直接查表
+    cv::Mat gain_lut2;
+    cv::Vec3f lut_gain1;         // 查找表建立时的增益，增益明显变化时才重建
+    cv::Vec3f lut_gain2;
+
+    // 合成图块：画布按 tile_size 划分，每块的类型见 TileType
+    int tile_size = 64;
+    int tile_cols = 0;
+    int tile_rows = 0;
+    std::vector<uchar> tile_types;
+
+    // 由调用方设置，重新标定时保留
+    FusionBlendMode blend_mode = FUSION_BLEND_FEATHER;
+    FusionMotionModel motion_model = FUSION_MODEL_HOMOGRAPHY;
+    double focal = 0;            // 旋转模型的焦距（像素）
+    bool gain_compensation = true;
+    AVPixelFormat output_format = AV_PIX_FMT_BGR24;  // 输出帧格式，见 output_pixel_layout()
+    std::shared_ptr<PyramidBlender> pyramid_blender;  // 金字塔缓冲跨帧复用，标定后重建
+    cv::Mat overlap_buffer1;     // 多频段融合时两幅图重叠区的缓冲，跨帧复用
+    cv::Mat overlap_buffer2;
+};
+
+bool calibrate_fusion(const cv::Mat &img1, const cv::Mat &img2, FusionCalibration &calibration,
+                      const cv::Mat &raw1 = cv::Mat(), const cv::Mat &raw2 = cv::Mat());
+
+bool image_fusion(AVFrame *frame1, AVFrame *frame2, AVFrame *frame_fused, bool is_correct,
+                  FusionCalibration *calibration = nullptr);
 
 #endif // STITCHER_H
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef WARP_MAPS_H
+#define WARP_MAPS_H
+
+#include <opencv2/core.hpp>
+
+/**
+ * Precomputed fixed-point remap tables shared by every geometric warp.
+ *
+ * Holds, for each output pixel, its source coordinate in the cv::convertMaps() CV_16SC2 +
+ * CV_16UC1 layout, so applying the warp is a table lookup plus bilinear interpolation with
+ * no per-pixel floating-point model evaluation.
+ */
+struct WarpMaps {
+    cv::Mat map1;                // 整数坐标，CV_16SC2
+    cv::Mat map2;                // 插值系数下标，CV_16UC1
+    cv::Mat mask;                // 源坐标落在输入图像内的输出像素，CV_8UC1
+
+    bool empty() const { return map1.empty(); }
+    cv::Size size() const { return map1.size(); }
+};
+
+void build_warp_maps(const cv::Mat &map_x, const cv::Mat &map_y, const cv::Size &src_size, WarpMaps &maps);
+
+void apply_warp_maps(const cv::Mat &src, const WarpMaps &maps, cv::Mat &dst);
+
+void apply_warp_maps(const cv::Mat &src, const WarpMaps &maps, const cv::Range &rows, cv::Mat &dst);
+
+#endif // WARP_MAPS_H
@@ -0,0 +1,15 @@
+#ifndef YUV_CONVERT_H
+#define YUV_CONVERT_H
+
+#include <opencv2/core.hpp>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+void bgr_to_yuv420_rows(const uchar *bgr0, const uchar *bgr1, int width,
+                        uchar *y0, uchar *y1, uchar *u, uchar *v, int uv_step);
+
+void store_yuv420_rows(const uchar *bgr0, const uchar *bgr1, int width, int x, int y, AVFrame *frame);
+
+#endif // YUV_CONVERT_H
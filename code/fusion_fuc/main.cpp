@@ -40,7 +40,8 @@ int main(int argc, char** argv) {
     bool success = image_fusion(frame1, frame2, frame_fused, false);
     if (success) {
         std::cout << "图像拼接成功！" << std::endl;
-        // 处理输出帧，如保存或显示
+        // 拼接结果直接写在输出帧里，需要时再转回 cv::Mat 保存
+        cv::imwrite("fused.jpg", avframeToCvmat(frame_fused));
     } else {
         std::cerr << "图像拼接失败！" << std::endl;
     }
@@ -0,0 +1,23 @@
+# 像素内核的指令集版本：src/pixel_kernels.inl 以 SSE4.2、AVX2、AVX-512 选项各编译一次，
+# 运行时由 src/pixel_kernels.cpp 按 CPUID 选择，不需要以 -march=native 构建整个库。
+#
+# 包含前设置 FUSION_DIR 为 fusion_fuc 目录，把 PIXEL_KERNEL_SOURCES 加入目标的源文件。
+# 源文件属性只在包含本文件的目录内生效。
+
+set(PIXEL_KERNEL_SOURCES ${FUSION_DIR}/src/pixel_kernels.cpp)
+
+if(CMAKE_SYSTEM_PROCESSOR MATCHES "^(x86_64|AMD64|amd64)$" AND CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+    set_source_files_properties(${FUSION_DIR}/src/pixel_kernels_sse42.cpp PROPERTIES
+        COMPILE_FLAGS "-O3 -msse4.2 -mpopcnt")
+    set_source_files_properties(${FUSION_DIR}/src/pixel_kernels_avx2.cpp PROPERTIES
+        COMPILE_FLAGS "-O3 -mavx2 -mfma -mpopcnt")
+    set_source_files_properties(${FUSION_DIR}/src/pixel_kernels_avx512.cpp PROPERTIES
+        COMPILE_FLAGS "-O3 -mavx512f -mavx512cd -mavx512bw -mavx512dq -mavx512vl -mavx2 -mfma -mpopcnt -mprefer-vector-width=512")
+    set_source_files_properties(${FUSION_DIR}/src/pixel_kernels.cpp PROPERTIES
+        COMPILE_DEFINITIONS FUSION_PIXEL_KERNELS_X86)
+    list(APPEND PIXEL_KERNEL_SOURCES
+        ${FUSION_DIR}/src/pixel_kernels_sse42.cpp
+        ${FUSION_DIR}/src/pixel_kernels_avx2.cpp
+        ${FUSION_DIR}/src/pixel_kernels_avx512.cpp
+    )
+endif()
@@ -0,0 +1,191 @@
+#include "../include/anms.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+// 鲁棒 ANMS 系数：只有响应明显更强 (resp_i < c * resp_j) 的点才能抑制当前点
+static const float ANMS_ROBUST_COEFF = 0.9f;
+// 每个网格内参与 ANMS 的候选点上限（相对于配额的倍数），限制 O(k^2) 的开销
+static const int ANMS_CANDIDATE_FACTOR = 4;
+
+/**
+ * Runs robust adaptive non-maximal suppression on the keypoints of one tile.
+ *
+ * The candidates must already be sorted by descending response. For every point the
+ * suppression radius is the squared distance to the nearest significantly stronger point;
+ * the points with the largest radii are the strongest, best spread ones.
+ *
+ * @param keypoints All keypoints of the image.
+ * @param candidates Indices of the tile's keypoints, sorted by descending response.
+ * @param radii Output squared suppression radius for every candidate.
+ */
+static void compute_suppression_radii(const std::vector<cv::KeyPoint> &keypoints,
+                                      const std::vector<int> &candidates,
+                                      std::vector<float> &radii)
+{
+    radii.assign(candidates.size(), std::numeric_limits<float>::max());
+
+    for (size_t i = 1; i < candidates.size(); i++) {
+        const cv::KeyPoint &kp_i = keypoints[candidates[i]];
+        float best = std::numeric_limits<float>::max();
+
+        // 只和更强的点比较（候选已按响应降序排列）
+        for (size_t j = 0; j < i; j++) {
+            const cv::KeyPoint &kp_j = keypoints[candidates[j]];
+            if (kp_i.response >= ANMS_ROBUST_COEFF * kp_j.response) {
+                continue;
+            }
+            float dx = kp_i.pt.x - kp_j.pt.x;
+            float dy = kp_i.pt.y - kp_j.pt.y;
+            best = std::min(best, dx * dx + dy * dy);
+        }
+        radii[i] = best;
+    }
+}
+
+//************************************
+// Method:    anms_grid_filter
+// Access:    public
+// Returns:   std::vector<cv::KeyPoint>
+// Qualifier:
+// Parameter: const std::vector<cv::KeyPoint> & keypoints
+// Parameter: const cv::Size & image_size
+// Parameter: int max_keypoints
+// Parameter: int grid_cols
+// Parameter: int grid_rows
+// Description: 网格分桶 + ANMS，按预算保留空间分布均匀的特征点
+//************************************
+std::vector<cv::KeyPoint> anms_grid_filter(const std::vector<cv::KeyPoint> &keypoints,
+                                           const cv::Size &image_size,
+                                           int max_keypoints,
+                                           int grid_cols,
+                                           int grid_rows)
+{
+    if (max_keypoints <= 0 || static_cast<int>(keypoints.size()) <= max_keypoints) {
+        return keypoints;
+    }
+    if (image_size.width <= 0 || image_size.height <= 0 || grid_cols <= 0 || grid_rows <= 0) {
+        std::cerr << "Invalid image size or grid for ANMS." << std::endl;
+        return keypoints;
+    }
+
+    // 将特征点分配到网格中
+    int num_tiles = grid_cols * grid_rows;
+    std::vector<std::vector<int>> tiles(num_tiles);
+    float tile_w = static_cast<float>(image_size.width) / grid_cols;
+    float tile_h = static_cast<float>(image_size.height) / grid_rows;
+    for (int i = 0; i < static_cast<int>(keypoints.size()); i++) {
+        int tx = std::clamp(static_cast<int>(keypoints[i].pt.x / tile_w), 0, grid_cols - 1);
+        int ty = std::clamp(static_cast<int>(keypoints[i].pt.y / tile_h), 0, grid_rows - 1);
+        tiles[ty * grid_cols + tx].push_back(i);
+    }
+
+    int quota = (max_keypoints + num_tiles - 1) / num_tiles;
+    std::vector<int> selected;
+    selected.reserve(max_keypoints);
+    // 未被选中的候选点，用于填补纹理稀疏网格留下的预算
+    std::vector<std::pair<float, int>> leftovers;
+
+    std::vector<float> radii;
+    std::vector<int> order;
+    for (auto &tile : tiles) {
+        if (tile.empty()) {
+            continue;
+        }
+
+        // 按响应降序排列，只保留最强的一部分候选参与 ANMS
+        std::sort(tile.begin(), tile.end(), [&](int a, int b) {
+            return keypoints[a].response > keypoints[b].response;
+        });
+        size_t num_candidates = std::min(tile.size(), static_cast<size_t>(quota * ANMS_CANDIDATE_FACTOR));
+        tile.resize(num_candidates);
+
+        compute_suppression_radii(keypoints, tile, radii);
+
+        // 按抑制半径降序选出配额内的点
+        order.resize(tile.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return radii[a] > radii[b];
+        });
+
+        for (size_t k = 0; k < order.size(); k++) {
+            int idx = tile[order[k]];
+            if (static_cast<int>(k) < quota) {
+                selected.push_back(idx);
+            } else {
+                leftovers.emplace_back(radii[order[k]], idx);
+            }
+        }
+    }
+
+    // 配额取整可能超出预算，优先保留响应最强的点
+    if (static_cast<int>(selected.size()) > max_keypoints) {
+        std::partial_sort(selected.begin(), selected.begin() + max_keypoints, selected.end(), [&](int a, int b) {
+            return keypoints[a].response > keypoints[b].response;
+        });
+        selected.resize(max_keypoints);
+    }
+
+    // 用其余网格中抑制半径最大的点补足预算
+    int remaining = max_keypoints - static_cast<int>(selected.size());
+    if (remaining > 0 && !leftovers.empty()) {
+        int fill = std::min(remaining, static_cast<int>(leftovers.size()));
+        std::partial_sort(leftovers.begin(), leftovers.begin() + fill, leftovers.end(),
+                          [](const std::pair<float, int> &a, const std::pair<float, int> &b) {
+                              return a.first > b.first;
+                          });
+        for (int k = 0; k < fill; k++) {
+            selected.push_back(leftovers[k].second);
+        }
+    }
+
+    std::vector<cv::KeyPoint> result;
+    result.reserve(selected.size());
+    for (int idx : selected) {
+        result.push_back(keypoints[idx]);
+    }
+    return result;
+}
+
+/**
+ * Detects keypoints, keeps a spatially uniform subset and computes descriptors for it only.
+ *
+ * Detection is run on the whole image, then anms_grid_filter() reduces the set to
+ * max_keypoints before compute() is called, so descriptor work scales with the budget
+ * instead of with scene texture.
+ *
+ * @param detector The feature detector/descriptor extractor (ORB, SIFT, ...).
+ * @param image The input image.
+ * @param mask Optional detection mask, may be empty.
+ * @param max_keypoints The keypoint budget for the whole image.
+ * @param keypoints Output keypoints.
+ * @param descriptors Output descriptors, one row per keypoint.
+ * @return True if at least one keypoint was kept, false otherwise.
+ */
+bool detect_and_compute_uniform(const cv::Ptr<cv::Feature2D> &detector,
+                                const cv::Mat &image,
+                                const cv::Mat &mask,
+                                int max_keypoints,
+                                std::vector<cv::KeyPoint> &keypoints,
+                                cv::Mat &descriptors)
+{
+    keypoints.clear();
+    descriptors.release();
+    if (!detector || image.empty()) {
+        return false;
+    }
+
+    std::vector<cv::KeyPoint> detected;
+    detector->detect(image, detected, mask);
+    if (detected.empty()) {
+        return false;
+    }
+
+    keypoints = anms_grid_filter(detected, image.size(), max_keypoints);
+    detector->compute(image, keypoints, descriptors);
+
+    return !keypoints.empty();
+}
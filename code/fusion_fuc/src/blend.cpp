@@ -0,0 +1,410 @@
+#include "../include/blend.h"
+#include "../include/gaussian_blur.h"
+#include "../include/pixel_kernels.h"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// 金字塔下采样前的高斯模糊 sigma
+static const double PYRAMID_SIGMA = 1.0;
+
+// 增益变化小于此值时查找表的任何一项最多变化 1，不必重建
+static const float GAIN_LUT_TOLERANCE = 0.5f / 255;
+
+// GRAY8、BGR24 或 BGRA32 图像的灰度，GRAY8 直接引用原图
+static cv::Mat gray_of(const cv::Mat &image)
+{
+    if (image.channels() == 1) {
+        return image;
+    }
+    cv::Mat gray;
+    cv::cvtColor(image, gray, image.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+    return gray;
+}
+
+/**
+ * Builds the per-column feather weights of img2 across the overlap.
+ *
+ * The weight rises linearly from 0 to BLEND_WEIGHT_ONE towards img2's side, so it only
+ * depends on the overlap width and is computed once per calibration.
+ *
+ * @param width The overlap width in pixels.
+ * @param img2_on_right Whether img2 lies to the right of img1 on the canvas.
+ * @param ramp Output weights, one per column.
+ */
+void build_feather_ramp(int width, bool img2_on_right, std::vector<ushort> &ramp)
+{
+    ramp.resize(std::max(width, 0));
+    for (int x = 0; x < width; x++) {
+        int w = width > 1 ? (x * BLEND_WEIGHT_ONE + (width - 1) / 2) / (width - 1) : BLEND_WEIGHT_ONE / 2;
+        ramp[x] = static_cast<ushort>(img2_on_right ? w : BLEND_WEIGHT_ONE - w);
+    }
+}
+
+/**
+ * Finds a vertical seam through the overlap by dynamic programming.
+ *
+ * The cost of a pixel is the colour difference plus the gradient difference of the two
+ * images; pixels img2 does not cover are effectively forbidden. The seam moves at most
+ * one column per row, so the cheapest path follows regions where the images agree.
+ *
+ * @param img1 The img1 overlap region (GRAY8, BGR24 or BGRA32).
+ * @param img2 The warped img2 overlap region, same type as img1.
+ * @param mask2 The img2 validity mask (CV_8UC1), or empty if img2 covers the region.
+ * @param seam Output seam column for every row, in region coordinates.
+ */
+void find_seam(const cv::Mat &img1, const cv::Mat &img2, const cv::Mat &mask2, std::vector<int> &seam)
+{
+    CV_Assert(img1.depth() == CV_8U && img1.type() == img2.type() && img1.size() == img2.size());
+
+    int rows = img1.rows;
+    int cols = img1.cols;
+    seam.assign(rows, cols / 2);
+    if (rows == 0 || cols == 0) {
+        return;
+    }
+
+    // 梯度差：灰度图的 Sobel 导数
+    cv::Mat gray1 = gray_of(img1), gray2 = gray_of(img2);
+    cv::Mat gx1, gy1, gx2, gy2;
+    cv::Sobel(gray1, gx1, CV_16S, 1, 0);
+    cv::Sobel(gray1, gy1, CV_16S, 0, 1);
+    cv::Sobel(gray2, gx2, CV_16S, 1, 0);
+    cv::Sobel(gray2, gy2, CV_16S, 0, 1);
+
+    const float invalid_cost = 1e6f;
+    int cn = std::min(img1.channels(), 3);  // 颜色差不计 alpha
+    int pixel = img1.channels();
+    cv::Mat cost(rows, cols, CV_32F);
+    for (int y = 0; y < rows; y++) {
+        const uchar *p1 = img1.ptr<uchar>(y);
+        const uchar *p2 = img2.ptr<uchar>(y);
+        const uchar *valid = mask2.empty() ? nullptr : mask2.ptr<uchar>(y);
+        const short *dx1 = gx1.ptr<short>(y), *dy1 = gy1.ptr<short>(y);
+        const short *dx2 = gx2.ptr<short>(y), *dy2 = gy2.ptr<short>(y);
+        float *c = cost.ptr<float>(y);
+        for (int x = 0; x < cols; x++) {
+            if (valid && !valid[x]) {
+                c[x] = invalid_cost;
+                continue;
+            }
+            int colour = 0;
+            for (int ch = 0; ch < cn; ch++) {
+                colour += std::abs(p1[pixel * x + ch] - p2[pixel * x + ch]);
+            }
+            int gradient = std::abs(dx1[x] - dx2[x]) + std::abs(dy1[x] - dy2[x]);
+            c[x] = static_cast<float>(colour) + 0.25f * gradient;
+        }
+    }
+
+    // 逐行累加代价，记录来自上一行的哪一列
+    cv::Mat from(rows, cols, CV_8S);
+    for (int y = 1; y < rows; y++) {
+        const float *prev = cost.ptr<float>(y - 1);
+        float *cur = cost.ptr<float>(y);
+        schar *dir = from.ptr<schar>(y);
+        for (int x = 0; x < cols; x++) {
+            int best = 0;
+            float best_cost = prev[x];
+            if (x > 0 && prev[x - 1] < best_cost) {
+                best = -1;
+                best_cost = prev[x - 1];
+            }
+            if (x + 1 < cols && prev[x + 1] < best_cost) {
+                best = 1;
+                best_cost = prev[x + 1];
+            }
+            cur[x] += best_cost;
+            dir[x] = static_cast<schar>(best);
+        }
+    }
+
+    // 从最后一行的最小代价处回溯
+    const float *last = cost.ptr<float>(rows - 1);
+    int x = static_cast<int>(std::min_element(last, last + cols) - last);
+    for (int y = rows - 1; y >= 0; y--) {
+        seam[y] = x;
+        if (y > 0) {
+            x += from.ptr<schar>(y)[x];
+        }
+    }
+}
+
+/**
+ * Builds the img2 weights around a seam as one table shared by all rows.
+ *
+ * The table has 2 * width + band entries: img1's weight on img1's side, a linear ramp
+ * over the band, img2's full weight on img2's side. A row whose band starts at column b0
+ * reads its weights from ramp.data() + width - b0.
+ *
+ * @param width The overlap width in pixels.
+ * @param band The width of the blended band around the seam.
+ * @param img2_on_right Whether img2 lies to the right of img1 on the canvas.
+ * @param ramp Output weights.
+ */
+void build_seam_ramp(int width, int band, bool img2_on_right, std::vector<ushort> &ramp)
+{
+    std::vector<ushort> band_ramp;
+    build_feather_ramp(band, true, band_ramp);
+
+    ramp.resize(2 * width + band);
+    for (int i = 0; i < static_cast<int>(ramp.size()); i++) {
+        int pos = i - width;
+        int w = pos < 0 ? 0 : (pos >= band ? BLEND_WEIGHT_ONE : band_ramp[pos]);
+        ramp[i] = static_cast<ushort>(img2_on_right ? w : BLEND_WEIGHT_ONE - w);
+    }
+}
+
+/**
+ * Seam-blends part of one overlap row.
+ *
+ * Only the columns [x_begin, x_end) of the row are touched, so callers working on tiles
+ * can blend just their own span; src2, mask2 and dst point at column x_begin.
+ *
+ * @param kernels The row kernels of the pixel layout, from pixel_row_kernels().
+ * @param src2 The warped img2 pixels.
+ * @param mask2 The img2 validity mask, or nullptr if img2 covers the span.
+ * @param dst The pixels holding img1 on input and the result on output.
+ * @param x_begin The first column of the span, in overlap coordinates.
+ * @param x_end One past the last column of the span.
+ * @param seam_x The seam column of this row.
+ * @param width The overlap width.
+ * @param band The width of the blended band.
+ * @param img2_on_right Whether img2 lies to the right of the seam.
+ * @param ramp The table from build_seam_ramp() for this width and band.
+ * @param lut2 Optional per-channel table (channels * 256 bytes, interleaved) applied to img2, or nullptr.
+ * @param scratch A buffer of at least channels * (x_end - x_begin) bytes, used when lut2 is set.
+ */
+void seam_blend_span(const PixelRowKernels &kernels, const uchar *src2, const uchar *mask2, uchar *dst, int x_begin, int x_end,
+                     int seam_x, int width, int band, bool img2_on_right,
+                     const std::vector<ushort> &ramp, const uchar *lut2, uchar *scratch)
+{
+    // 图像 2 一侧加窄带的列范围，再与本段求交
+    int b0 = std::min(std::max(seam_x - band / 2, -band), width);
+    int lo = img2_on_right ? std::max(b0, 0) : 0;
+    int hi = img2_on_right ? width : std::min(std::max(b0 + band, 0), width);
+    lo = std::max(lo, x_begin);
+    hi = std::min(hi, x_end);
+    if (hi <= lo) {
+        return;
+    }
+
+    int cn = kernels.channels;
+    int offset = lo - x_begin;
+    const uchar *src = src2 + cn * offset;
+    if (lut2) {
+        kernels.copy[0][1](src, nullptr, lut2, scratch, hi - lo);
+        src = scratch;
+    }
+    uchar *row = dst + cn * offset;
+    kernels.feather_blend[mask2 != nullptr](row, src, mask2 ? mask2 + offset : nullptr,
+                                            ramp.data() + width - b0 + lo, row, hi - lo);
+}
+
+/**
+ * Per-channel means of two images over the pixels both of them cover.
+ *
+ * Only every step-th pixel of every step-th row is read, so a refresh costs about
+ * 1 / step² of the overlap.
+ *
+ * @param img1 The img1 overlap region (GRAY8, BGR24 or BGRA32).
+ * @param img2 The warped img2 overlap region, same type as img1.
+ * @param mask2 The img2 validity mask (CV_8UC1), or empty if img2 covers the region.
+ * @param step The sampling step in both directions.
+ * @param mean1 Output BGR mean of img1; a GRAY8 mean is repeated in all three channels,
+ *              alpha is ignored.
+ * @param mean2 Output BGR mean of img2.
+ * @return True if at least one pixel was sampled, false otherwise.
+ */
+bool overlap_channel_means(const cv::Mat &img1, const cv::Mat &img2, const cv::Mat &mask2, int step,
+                           cv::Vec3d &mean1, cv::Vec3d &mean2)
+{
+    CV_Assert(img1.depth() == CV_8U && img1.type() == img2.type() && img1.size() == img2.size());
+
+    int pixel = img1.channels();
+    int cn = std::min(pixel, 3);
+    step = std::max(step, 1);
+    cv::Vec3d sum1(0, 0, 0), sum2(0, 0, 0);
+    long count = 0;
+    for (int y = 0; y < img1.rows; y += step) {
+        const uchar *p1 = img1.ptr<uchar>(y);
+        const uchar *p2 = img2.ptr<uchar>(y);
+        const uchar *valid = mask2.empty() ? nullptr : mask2.ptr<uchar>(y);
+        for (int x = 0; x < img1.cols; x += step) {
+            if (valid && !valid[x]) {
+                continue;
+            }
+            for (int c = 0; c < cn; c++) {
+                sum1[c] += p1[pixel * x + c];
+                sum2[c] += p2[pixel * x + c];
+            }
+            count++;
+        }
+    }
+
+    if (count == 0) {
+        return false;
+    }
+    for (int c = cn; c < 3; c++) {
+        sum1[c] = sum1[0];
+        sum2[c] = sum2[0];
+    }
+    mean1 = sum1 / static_cast<double>(count);
+    mean2 = sum2 / static_cast<double>(count);
+    return true;
+}
+
+/**
+ * Builds the 256-entry per-channel gain table used by cv::LUT and seam_blend_span().
+ *
+ * GRAY8 uses the blue gain (all three are equal for grey input); the alpha channel of
+ * BGRA32 is passed through unchanged.
+ *
+ * @param gain The BGR gains.
+ * @param channels The channel count of the pixel layout, 1, 3 or 4.
+ * @param lut Output 1 x 256 CV_8UC(channels) table.
+ */
+void build_gain_lut(const cv::Vec3f &gain, int channels, cv::Mat &lut)
+{
+    lut.create(1, 256, CV_8UC(channels));
+    uchar *entry = lut.ptr<uchar>();
+    for (int v = 0; v < 256; v++) {
+        for (int c = 0; c < channels; c++) {
+            entry[channels * v + c] = c < 3 ? cv::saturate_cast<uchar>(v * gain[c]) : static_cast<uchar>(v);
+        }
+    }
+}
+
+/**
+ * Rebuilds a gain table only when the gain has moved since the table was built.
+ *
+ * Smoothed gains drift by tiny amounts every frame; below GAIN_LUT_TOLERANCE the table
+ * would come out (almost) the same, so it is kept.
+ *
+ * @param gain The current BGR gains.
+ * @param channels The channel count of the pixel layout.
+ * @param lut_gain The gains the table was built from; updated when the table is rebuilt.
+ * @param lut The 1 x 256 CV_8UC(channels) table, built if empty or of another layout.
+ * @return True if the table was rebuilt.
+ */
+bool update_gain_lut(const cv::Vec3f &gain, int channels, cv::Vec3f &lut_gain, cv::Mat &lut)
+{
+    if (!lut.empty() && lut.channels() == channels) {
+        float moved = 0;
+        for (int c = 0; c < 3; c++) {
+            moved = std::max(moved, std::abs(gain[c] - lut_gain[c]));
+        }
+        if (moved < GAIN_LUT_TOLERANCE) {
+            return false;
+        }
+    }
+    build_gain_lut(gain, channels, lut);
+    lut_gain = gain;
+    return true;
+}
+
+// 模糊后隔点取样，尺寸向上取整
+static void pyramid_down(const cv::Mat &src, cv::Mat &blurred, cv::Mat &dst)
+{
+    gaussian_blur(src, blurred, PYRAMID_SIGMA);
+    cv::resize(blurred, dst, cv::Size((src.cols + 1) / 2, (src.rows + 1) / 2), 0, 0, cv::INTER_NEAREST);
+}
+
+static void pyramid_up(const cv::Mat &src, const cv::Size &size, cv::Mat &dst)
+{
+    cv::resize(src, dst, size, 0, 0, cv::INTER_LINEAR);
+}
+
+PyramidBlender::PyramidBlender(int num_bands)
+    : num_bands_(std::max(num_bands, 1))
+{
+}
+
+/**
+ * Sets the blend region and the img2 weights, normally once per calibration.
+ *
+ * The band count is reduced for small regions so the coarsest level keeps a few pixels.
+ *
+ * @param mask2 CV_8UC1 mask of the region, 255 where img2 should win and 0 where img1 should.
+ */
+void PyramidBlender::set_mask(const cv::Mat &mask2)
+{
+    CV_Assert(mask2.type() == CV_8UC1);
+
+    weight_pyr_.clear();
+    if (mask2.empty()) {
+        return;
+    }
+
+    int min_side = std::min(mask2.cols, mask2.rows);
+    int bands = std::min(num_bands_, std::max(1, static_cast<int>(std::log2(std::max(min_side, 1))) - 1));
+
+    cv::Mat blurred;
+    weight_pyr_.resize(bands);
+    mask2.convertTo(weight_pyr_[0], CV_32F, 1.0 / 255);
+    for (int i = 1; i < bands; i++) {
+        pyramid_down(weight_pyr_[i - 1], blurred, weight_pyr_[i]);
+    }
+    blurred_.resize(bands);
+    expanded_.resize(bands);
+}
+
+// 原地构建：每层先下采样得到下一层高斯图像，再减去其上采样结果；各层缓冲跨帧复用
+void PyramidBlender::build_laplacian(const cv::Mat &src, std::vector<cv::Mat> &pyr)
+{
+    int bands = static_cast<int>(weight_pyr_.size());
+    pyr.resize(bands);
+    src.convertTo(pyr[0], CV_32F);
+    for (int i = 0; i + 1 < bands; i++) {
+        pyramid_down(pyr[i], blurred_[i], pyr[i + 1]);
+        pyramid_up(pyr[i + 1], pyr[i].size(), expanded_[i]);
+        cv::subtract(pyr[i], expanded_[i], pyr[i]);
+    }
+}
+
+/**
+ * Blends two equally sized regions band by band.
+ *
+ * @param img1 The img1 region (8-bit, any channel count), same size as the mask.
+ * @param img2 The warped img2 region, same type as img1.
+ * @param dst The output region, may be the same memory as img1 or img2.
+ */
+void PyramidBlender::blend(const cv::Mat &img1, const cv::Mat &img2, cv::Mat &dst)
+{
+    CV_Assert(!empty() && img1.size() == size() && img2.size() == size());
+    CV_Assert(img1.depth() == CV_8U && img1.type() == img2.type());
+
+    build_laplacian(img1, lap1_);
+    build_laplacian(img2, lap2_);
+
+    // 每层按该层的权重混合，结果写回 lap1_
+    int bands = static_cast<int>(weight_pyr_.size());
+    int cn = img1.channels();
+    for (int i = 0; i < bands; i++) {
+        cv::Mat &l1 = lap1_[i];
+        const cv::Mat &l2 = lap2_[i];
+        const cv::Mat &w = weight_pyr_[i];
+        cv::parallel_for_(cv::Range(0, l1.rows), [&](const cv::Range &range) {
+            for (int y = range.start; y < range.end; y++) {
+                float *p1 = l1.ptr<float>(y);
+                const float *p2 = l2.ptr<float>(y);
+                const float *pw = w.ptr<float>(y);
+                for (int x = 0; x < l1.cols; x++) {
+                    for (int c = 0; c < cn; c++) {
+                        p1[cn * x + c] += pw[x] * (p2[cn * x + c] - p1[cn * x + c]);
+                    }
+                }
+            }
+        });
+    }
+
+    // 从最粗一层开始逐层上采样累加
+    for (int i = bands - 2; i >= 0; i--) {
+        pyramid_up(lap1_[i + 1], lap1_[i].size(), expanded_[i]);
+        cv::add(lap1_[i], expanded_[i], lap1_[i]);
+    }
+
+    lap1_[0].convertTo(dst, CV_8U);
+}
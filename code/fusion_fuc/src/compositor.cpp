@@ -0,0 +1,234 @@
+#include "../include/compositor.h"
+#include "../include/yuv_convert.h"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <vector>
+
+// 图像 2 在画布像素 (x, y) 处是否参与输出：有效，且不在图像 1 内，或位于接缝的图像 2 一侧及窄带内
+static bool img2_contributes(const FusionCalibration &calibration, int x, int y)
+{
+    const cv::Rect &warp_rect = calibration.warp_rect;
+    const cv::Rect &overlap_rect = calibration.overlap_rect;
+    cv::Point p(x, y);
+
+    if (!warp_rect.contains(p) || !calibration.warp_mask.at<uchar>(y - warp_rect.y, x - warp_rect.x)) {
+        return false;
+    }
+    if (!overlap_rect.contains(p)) {
+        return true;
+    }
+
+    int band = calibration.seam_band;
+    int b0 = std::min(std::max(calibration.seam[y - overlap_rect.y] - band / 2, -band), overlap_rect.width);
+    int ox = x - overlap_rect.x;
+    return calibration.img2_on_right ? ox >= b0 : ox < b0 + band;
+}
+
+/**
+ * Classifies every canvas tile by which images contribute to it.
+ *
+ * Runs once per calibration, after the seam has been found.
+ *
+ * @param calibration The calibration whose tile grid is filled in.
+ */
+void classify_tiles(FusionCalibration &calibration)
+{
+    int tile = calibration.tile_size;
+    calibration.tile_cols = (calibration.canvas_size.width + tile - 1) / tile;
+    calibration.tile_rows = (calibration.canvas_size.height + tile - 1) / tile;
+    calibration.tile_types.assign(calibration.tile_cols * calibration.tile_rows, TILE_EMPTY);
+
+    cv::Rect canvas_rect(cv::Point(0, 0), calibration.canvas_size);
+    cv::parallel_for_(cv::Range(0, static_cast<int>(calibration.tile_types.size())), [&](const cv::Range &range) {
+        for (int idx = range.start; idx < range.end; idx++) {
+            cv::Rect t((idx % calibration.tile_cols) * tile, (idx / calibration.tile_cols) * tile, tile, tile);
+            t &= canvas_rect;
+
+            bool has1 = !(t & calibration.img1_rect).empty();
+            bool has2 = false;
+            cv::Rect r2 = t & calibration.warp_rect;
+            for (int y = r2.y; y < r2.y + r2.height && !has2; y++) {
+                for (int x = r2.x; x < r2.x + r2.width; x++) {
+                    if (img2_contributes(calibration, x, y)) {
+                        has2 = true;
+                        break;
+                    }
+                }
+            }
+
+            calibration.tile_types[idx] = static_cast<uchar>(
+                has2 ? (has1 ? TILE_BLEND : TILE_IMG2) : (has1 ? TILE_IMG1 : TILE_EMPTY));
+        }
+    });
+}
+
+// 图像 2 -> 画布区域 region 局部坐标的单应矩阵
+cv::Mat region_homography(const FusionCalibration &calibration, const cv::Rect &region)
+{
+    cv::Point shift = calibration.warp_rect.tl() - region.tl();
+    cv::Mat offset = (cv::Mat_<double>(3, 3) << 1, 0, shift.x, 0, 1, shift.y, 0, 0, 1);
+    return offset * calibration.warp_homography;
+}
+
+// 混合图块：先写图像 1，再把图像 2 变换到图块缓冲，按行拷贝图像 1 以外的部分、混合重叠部分
+static void composite_blend_tile(const cv::Mat &img1, const cv::Mat &img2, const FusionCalibration &calibration,
+                                 const cv::Rect &t, bool skip_overlap, cv::Mat &tile_out,
+                                 cv::Mat &warp_buf, std::vector<uchar> &scratch)
+{
+    bool use_gain = calibration.gain_compensation;
+    const uchar *lut2 = use_gain ? calibration.gain_lut2.ptr<uchar>() : nullptr;
+    const PixelRowKernels &kernels = *calibration.row_kernels;
+    CopyRowFn copy2 = kernels.copy[1][use_gain];  // 行循环外选定拷贝内核
+    int cn = kernels.channels;
+    const cv::Rect &img1_rect = calibration.img1_rect;
+    const cv::Rect &warp_rect = calibration.warp_rect;
+    const cv::Rect &overlap_rect = calibration.overlap_rect;
+
+    tile_out.setTo(cv::Scalar::all(0));
+    cv::Rect r1 = t & img1_rect;
+    cv::Mat out1 = tile_out(r1 - t.tl());
+    if (use_gain) {
+        cv::LUT(img1(r1 - img1_rect.tl()), calibration.gain_lut1, out1);
+    } else {
+        img1(r1 - img1_rect.tl()).copyTo(out1);
+    }
+
+    cv::Rect r2 = t & warp_rect;
+    if (r2.empty()) {
+        return;
+    }
+    cv::warpPerspective(img2, warp_buf, region_homography(calibration, r2), r2.size(),
+                        cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar::all(0));
+
+    int r2_end = r2.x + r2.width;
+    for (int y = r2.y; y < r2.y + r2.height; y++) {
+        const uchar *src = warp_buf.ptr<uchar>(y - r2.y);
+        const uchar *mask = calibration.warp_mask.ptr<uchar>(y - warp_rect.y) + (r2.x - warp_rect.x);
+        uchar *dst = tile_out.ptr<uchar>(y - t.y) + cn * (r2.x - t.x);
+
+        // 本行落在图像 1 内的列范围 [i0, i1)，此范围必在重叠区内
+        int i0 = r2_end, i1 = r2_end;
+        if (y >= img1_rect.y && y < img1_rect.y + img1_rect.height) {
+            i0 = std::min(std::max(img1_rect.x, r2.x), r2_end);
+            i1 = std::min(std::max(img1_rect.x + img1_rect.width, r2.x), r2_end);
+        }
+
+        copy2(src, mask, lut2, dst, i0 - r2.x);
+        copy2(src + cn * (i1 - r2.x), mask + (i1 - r2.x), lut2, dst + cn * (i1 - r2.x), r2_end - i1);
+
+        if (i1 > i0 && !skip_overlap) {
+            int offset = i0 - r2.x;
+            seam_blend_span(kernels, src + cn * offset, mask + offset, dst + cn * offset,
+                            i0 - overlap_rect.x, i1 - overlap_rect.x,
+                            calibration.seam[y - overlap_rect.y], overlap_rect.width,
+                            calibration.seam_band, calibration.img2_on_right,
+                            calibration.seam_ramp, lut2, scratch.data());
+        }
+    }
+}
+
+// 合成画布区域 t 的一个图块，tile_out 为图块局部坐标、画布像素布局的像素
+static void composite_tile(const cv::Mat &img1, const cv::Mat &img2, const FusionCalibration &calibration,
+                           const cv::Rect &t, int type, const cv::Mat &blended_overlap,
+                           cv::Mat &tile_out, cv::Mat &warp_buf, std::vector<uchar> &scratch)
+{
+    bool use_gain = calibration.gain_compensation;
+
+    switch (type) {
+    case TILE_EMPTY:
+        tile_out.setTo(cv::Scalar::all(0));
+        break;
+    case TILE_IMG1: {
+        cv::Rect r1 = t & calibration.img1_rect;
+        if (r1 != t) {
+            tile_out.setTo(cv::Scalar::all(0));
+        }
+        cv::Mat out1 = tile_out(r1 - t.tl());
+        if (use_gain) {
+            cv::LUT(img1(r1 - calibration.img1_rect.tl()), calibration.gain_lut1, out1);
+        } else {
+            img1(r1 - calibration.img1_rect.tl()).copyTo(out1);
+        }
+        break;
+    }
+    case TILE_IMG2:
+        // 落点外的像素由常数边界填零
+        cv::warpPerspective(img2, tile_out, region_homography(calibration, t), t.size(),
+                            cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar::all(0));
+        if (use_gain) {
+            cv::LUT(tile_out, calibration.gain_lut2, tile_out);
+        }
+        break;
+    default:
+        composite_blend_tile(img1, img2, calibration, t, !blended_overlap.empty(), tile_out, warp_buf, scratch);
+        break;
+    }
+
+    // 重叠区已由调用方融合好时直接覆盖
+    if (!blended_overlap.empty()) {
+        const cv::Rect &overlap_rect = calibration.overlap_rect;
+        cv::Rect ro = t & overlap_rect;
+        if (!ro.empty()) {
+            blended_overlap(ro - overlap_rect.tl()).copyTo(tile_out(ro - t.tl()));
+        }
+    }
+}
+
+/**
+ * Composites both images into the output frame tile by tile.
+ *
+ * Every output pixel is written once, by the path its tile was classified into, so there
+ * is no zeroed full canvas, no full-size warp buffer and no final copy. For GRAY8, BGR24
+ * and BGRA frames the tiles are composited straight into the frame's plane with the
+ * calibration's row kernels; for YUV420P and NV12 each tile is composited into a small
+ * BGR buffer and converted while it is still in cache. Tiles run in parallel and each
+ * thread keeps its own buffers.
+ *
+ * @param img1 The reference image, in the calibration's pixel layout.
+ * @param img2 The image warped onto img1, same type as img1.
+ * @param calibration A valid calibration with classified tiles.
+ * @param blended_overlap The already blended overlap, or empty to seam-blend it here.
+ * @param frame A canvas-sized frame of calibration.output_format with a writable buffer.
+ */
+void composite_tiles(const cv::Mat &img1, const cv::Mat &img2, const FusionCalibration &calibration,
+                     const cv::Mat &blended_overlap, AVFrame *frame)
+{
+    AVPixelFormat format = static_cast<AVPixelFormat>(frame->format);
+    CV_Assert(frame->width == calibration.canvas_size.width && frame->height == calibration.canvas_size.height);
+    CV_Assert(format == calibration.output_format && calibration.tile_size % 2 == 0);
+
+    int tile = calibration.tile_size;
+    int type = CV_8UC(calibration.row_kernels->channels);
+    CV_Assert(img1.type() == type && img2.type() == type);
+
+    // YUV 输出在 BGR24 图块缓冲上合成后转换，其余格式直接写入数据平面
+    bool yuv = format == AV_PIX_FMT_YUV420P || format == AV_PIX_FMT_NV12;
+    cv::Rect canvas_rect(cv::Point(0, 0), calibration.canvas_size);
+    cv::Mat canvas;
+    if (!yuv) {
+        canvas = cv::Mat(calibration.canvas_size, type, frame->data[0], frame->linesize[0]);
+    }
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(calibration.tile_types.size())), [&](const cv::Range &range) {
+        cv::Mat warp_buf;
+        cv::Mat tile_buf(tile, tile, type);
+        std::vector<uchar> scratch(CV_ELEM_SIZE(type) * tile);
+        for (int idx = range.start; idx < range.end; idx++) {
+            cv::Rect t((idx % calibration.tile_cols) * tile, (idx / calibration.tile_cols) * tile, tile, tile);
+            t &= canvas_rect;
+            cv::Mat tile_out = yuv ? tile_buf(cv::Rect(cv::Point(0, 0), t.size())) : canvas(t);
+
+            composite_tile(img1, img2, calibration, t, calibration.tile_types[idx], blended_overlap,
+                           tile_out, warp_buf, scratch);
+            if (!yuv) {
+                continue;
+            }
+            // 图块起点为偶数坐标，每个色度样本只属于一个图块
+            for (int y = 0; y < t.height; y += 2) {
+                const uchar *row1 = y + 1 < t.height ? tile_out.ptr<uchar>(y + 1) : nullptr;
+                store_yuv420_rows(tile_out.ptr<uchar>(y), row1, t.width, t.x, t.y + y, frame);
+            }
+        }
+    });
+}
@@ -0,0 +1,212 @@
+#include "../include/knn_matcher.h"
+#include "../include/pixel_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+// 计算两个 int8 向量的点积，按 CPU 选择的内核版本执行
+static inline int dot_int8(const schar *a, const schar *b, int len)
+{
+    return pixel_kernels().dot_int8(a, b, len);
+}
+
+// 对 a 的每一行在 b 中找汉明距离最近的行，按行并行
+static void hamming_nearest(const cv::Mat &a, const cv::Mat &b, std::vector<int> &best_idx, std::vector<int> &best_dist)
+{
+    int (*hamming)(const uchar *, const uchar *, int) = pixel_kernels().hamming_u8;
+    best_idx.assign(a.rows, -1);
+    best_dist.assign(a.rows, std::numeric_limits<int>::max());
+    cv::parallel_for_(cv::Range(0, a.rows), [&](const cv::Range &range) {
+        for (int i = range.start; i < range.end; i++) {
+            const uchar *row = a.ptr<uchar>(i);
+            for (int j = 0; j < b.rows; j++) {
+                int dist = hamming(row, b.ptr<uchar>(j), a.cols);
+                if (dist < best_dist[i]) {
+                    best_dist[i] = dist;
+                    best_idx[i] = j;
+                }
+            }
+        }
+    });
+}
+
+/**
+ * Quantizes float descriptors to int8 with the matcher's scale.
+ *
+ * @param src Float descriptors, one per row.
+ * @param dst Output CV_8S descriptors.
+ * @param norms Output squared norm of every quantized descriptor.
+ */
+void QuantizedKnnMatcher::quantize(const cv::Mat &src, cv::Mat &dst, std::vector<int> &norms) const
+{
+    src.convertTo(dst, CV_8S, scale_);
+
+    norms.resize(dst.rows);
+    for (int r = 0; r < dst.rows; r++) {
+        const schar *row = dst.ptr<schar>(r);
+        norms[r] = dot_int8(row, row, dst.cols);
+    }
+}
+
+/**
+ * Builds the quantized index from float train descriptors.
+ *
+ * The scale maps the largest train value to 127, so queries from the same camera stay in
+ * range; larger query values saturate.
+ *
+ * @param descriptors CV_32F train descriptors, one per row.
+ * @return True if the index was built, false otherwise.
+ */
+bool QuantizedKnnMatcher::train(const cv::Mat &descriptors)
+{
+    train_q_.release();
+    train_norms_.clear();
+
+    if (descriptors.empty() || descriptors.type() != CV_32F) {
+        std::cerr << "QuantizedKnnMatcher expects non-empty CV_32F descriptors." << std::endl;
+        return false;
+    }
+
+    double min_val = 0, max_val = 0;
+    cv::minMaxLoc(descriptors, &min_val, &max_val);
+    double range = std::max(std::abs(min_val), std::abs(max_val));
+    scale_ = range > 0 ? static_cast<float>(127.0 / range) : 1.0f;
+
+    quantize(descriptors, train_q_, train_norms_);
+    return true;
+}
+
+//************************************
+// Method:    knn_match
+// Access:    public
+// Returns:   void
+// Qualifier: const
+// Parameter: const cv::Mat & query
+// Parameter: std::vector<std::vector<cv::DMatch>> & matches
+// Parameter: int k
+// Description: 对每个查询描述子返回 k 个最近邻，距离换算回浮点 L2
+//************************************
+void QuantizedKnnMatcher::knn_match(const cv::Mat &query,
+                                    std::vector<std::vector<cv::DMatch>> &matches,
+                                    int k) const
+{
+    matches.clear();
+    if (empty() || query.empty() || k <= 0) {
+        return;
+    }
+    if (query.type() != CV_32F || query.cols != train_q_.cols) {
+        std::cerr << "Query descriptors do not match the trained index." << std::endl;
+        return;
+    }
+
+    cv::Mat query_q;
+    std::vector<int> query_norms;
+    quantize(query, query_q, query_norms);
+
+    int dims = train_q_.cols;
+    int num_train = train_q_.rows;
+    int kk = std::min(k, num_train);
+    float inv_scale = 1.0f / scale_;
+    matches.resize(query_q.rows);
+
+    // 查询之间相互独立，按行并行
+    cv::parallel_for_(cv::Range(0, query_q.rows), [&](const cv::Range &range) {
+        std::vector<int> best_dist(kk);
+        std::vector<int> best_idx(kk);
+
+        for (int q = range.start; q < range.end; q++) {
+            const schar *qrow = query_q.ptr<schar>(q);
+            std::fill(best_dist.begin(), best_dist.end(), std::numeric_limits<int>::max());
+            std::fill(best_idx.begin(), best_idx.end(), -1);
+
+            for (int t = 0; t < num_train; t++) {
+                int dist = query_norms[q] + train_norms_[t] - 2 * dot_int8(qrow, train_q_.ptr<schar>(t), dims);
+                if (dist >= best_dist[kk - 1]) {
+                    continue;
+                }
+                // 插入排序维护前 k 个最近邻
+                int pos = kk - 1;
+                while (pos > 0 && best_dist[pos - 1] > dist) {
+                    best_dist[pos] = best_dist[pos - 1];
+                    best_idx[pos] = best_idx[pos - 1];
+                    pos--;
+                }
+                best_dist[pos] = dist;
+                best_idx[pos] = t;
+            }
+
+            std::vector<cv::DMatch> &knn = matches[q];
+            knn.clear();
+            for (int j = 0; j < kk; j++) {
+                if (best_idx[j] < 0) {
+                    break;
+                }
+                float distance = std::sqrt(static_cast<float>(std::max(best_dist[j], 0))) * inv_scale;
+                knn.emplace_back(q, best_idx[j], distance);
+            }
+        }
+    });
+}
+
+/**
+ * Brute-force matches binary descriptors (ORB) by Hamming distance with a cross check.
+ *
+ * Equivalent to cv::BFMatcher(cv::NORM_HAMMING, true): a pair is kept only if each
+ * descriptor is the other's nearest neighbour. Distances come from the CPU-selected
+ * popcount kernel.
+ *
+ * @param query CV_8U query descriptors, one per row.
+ * @param train CV_8U train descriptors with the same width.
+ * @param matches Output mutual nearest-neighbour matches, in query order.
+ * @return True if the descriptors could be matched, false otherwise.
+ */
+bool hamming_cross_match(const cv::Mat &query, const cv::Mat &train, std::vector<cv::DMatch> &matches)
+{
+    matches.clear();
+    if (query.empty() || train.empty()) {
+        return true;
+    }
+    if (query.type() != CV_8U || train.type() != CV_8U || query.cols != train.cols) {
+        std::cerr << "Hamming matching expects CV_8U descriptors of the same width." << std::endl;
+        return false;
+    }
+
+    std::vector<int> forward_idx, forward_dist, backward_idx, backward_dist;
+    hamming_nearest(query, train, forward_idx, forward_dist);
+    hamming_nearest(train, query, backward_idx, backward_dist);
+    for (int q = 0; q < query.rows; q++) {
+        int t = forward_idx[q];
+        if (t >= 0 && backward_idx[t] == q) {
+            matches.emplace_back(q, t, static_cast<float>(forward_dist[q]));
+        }
+    }
+    return true;
+}
+
+/**
+ * Matches query descriptors against the index and applies Lowe's ratio test.
+ *
+ * @param query CV_32F query descriptors, one per row.
+ * @param matches Output matches that pass the ratio test.
+ * @param ratio The ratio between the best and second best distance, 0.7 by default.
+ */
+void QuantizedKnnMatcher::ratio_match(const cv::Mat &query,
+                                      std::vector<cv::DMatch> &matches,
+                                      float ratio) const
+{
+    matches.clear();
+
+    std::vector<std::vector<cv::DMatch>> knn_matches;
+    knn_match(query, knn_matches, 2);
+
+    for (const auto &knn : knn_matches) {
+        if (knn.size() < 2) {
+            continue;
+        }
+        if (knn[0].distance < ratio * knn[1].distance) {
+            matches.push_back(knn[0]);
+        }
+    }
+}
@@ -0,0 +1,857 @@
+#include "../include/panorama.h"
+#include "../include/yuv_convert.h"
+#include "../include/rotation_model.h"
+#include "../include/fusion_params.h"
+
+#include <opencv2/stitching/detail/autocalib.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+// 全局增益求解中亮度差和偏离 1 的标准差
+static const double PANORAMA_GAIN_SIGMA_N = 10.0;
+static const double PANORAMA_GAIN_SIGMA_G = 0.1;
+
+// 全局优化：非相邻相机对至少需要的内点数，每对参与优化的点数上限，迭代次数
+static const int PANORAMA_MIN_INLIERS = 30;
+static const int PANORAMA_MAX_PAIR_POINTS = 200;
+static const int PANORAMA_REFINE_ITERS = 50;
+
+// 每帧变换和查表按 (相机, 行条带) 划分工作项的条带高度
+static const int PANORAMA_STRIPE_ROWS = 32;
+
+// 一对相机的匹配内点，points_i 在相机 i 的坐标下
+struct PairMatches {
+    int i = 0;
+    int j = 0;
+    std::vector<cv::Point2f> points_i;
+    std::vector<cv::Point2f> points_j;
+};
+
+// 把单应矩阵的右下角归一化为 1
+static cv::Mat normalize_homography(const cv::Mat &h)
+{
+    return h / h.at<double>(2, 2);
+}
+
+// 均匀抽取不超过 max_points 个匹配，控制优化规模
+static void thin_matches(PairMatches &pair, int max_points)
+{
+    int n = static_cast<int>(pair.points_i.size());
+    if (n <= max_points) {
+        return;
+    }
+    std::vector<cv::Point2f> points_i, points_j;
+    for (int k = 0; k < max_points; k++) {
+        int idx = static_cast<int>(static_cast<long long>(k) * n / max_points);
+        points_i.push_back(pair.points_i[idx]);
+        points_j.push_back(pair.points_j[idx]);
+    }
+    pair.points_i.swap(points_i);
+    pair.points_j.swap(points_j);
+}
+
+// 估计相机 pair.j -> 相机 pair.i 的单应矩阵；给出原图时在原图上检测，只校正特征点坐标
+static bool match_cameras(const std::vector<cv::Mat> &images, const std::vector<cv::Mat> &raw_images,
+                          const PanoramaCalibration &calibration, cv::Mat &homography, PairMatches &pair)
+{
+    bool raw_input = !raw_images.empty();
+    const std::vector<cv::Mat> &source = raw_input ? raw_images : images;
+    return estimate_homography(source[pair.i], source[pair.j], homography, &pair.points_i, &pair.points_j,
+                               calibration.motion_model, calibration.focal, raw_input);
+}
+
+/**
+ * Estimates every camera's homography to the reference by chaining neighbouring pairs.
+ *
+ * @param images The calibration images, in rig order.
+ * @param raw_images The raw frames the images were corrected from, or empty.
+ * @param reference The reference camera.
+ * @param calibration The calibration whose motion model and focal length are used.
+ * @param homographies Output homographies, camera -> reference coordinates.
+ * @param pairs Receives the inlier matches of every neighbouring pair.
+ * @return True if every neighbouring pair could be matched, false otherwise.
+ */
+static bool chain_homographies(const std::vector<cv::Mat> &images, const std::vector<cv::Mat> &raw_images, int reference,
+                               const PanoramaCalibration &calibration,
+                               std::vector<cv::Mat> &homographies, std::vector<PairMatches> &pairs)
+{
+    int n = static_cast<int>(images.size());
+
+    // next_to_prev[i]：相机 i + 1 -> 相机 i
+    std::vector<cv::Mat> next_to_prev(n - 1);
+    for (int i = 0; i + 1 < n; i++) {
+        PairMatches pair;
+        pair.i = i;
+        pair.j = i + 1;
+        if (!match_cameras(images, raw_images, calibration, next_to_prev[i], pair)) {
+            std::cerr << "Could not match camera " << i << " and camera " << i + 1 << "." << std::endl;
+            return false;
+        }
+        thin_matches(pair, PANORAMA_MAX_PAIR_POINTS);
+        pairs.push_back(pair);
+    }
+
+    homographies.assign(n, cv::Mat());
+    homographies[reference] = cv::Mat::eye(3, 3, CV_64F);
+    for (int i = reference + 1; i < n; i++) {
+        homographies[i] = normalize_homography(homographies[i - 1] * next_to_prev[i - 1]);
+    }
+    for (int i = reference - 1; i >= 0; i--) {
+        homographies[i] = normalize_homography(homographies[i + 1] * next_to_prev[i].inv());
+    }
+    return true;
+}
+
+// 相机 i 的 8 个参数在参数向量中的位置，参考相机固定为单位矩阵、不占参数
+static int param_slot(int camera, int reference)
+{
+    return camera < reference ? camera : camera - 1;
+}
+
+static cv::Matx33d homography_from_params(const double *p)
+{
+    return cv::Matx33d(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], 1.0);
+}
+
+// 旋转模型下每个相机 3 个参数（旋转向量），H = K_ref * R * K^-1
+static cv::Matx33d rotation_from_params(const double *p)
+{
+    cv::Matx33d r;
+    cv::Rodrigues(cv::Vec3d(p[0], p[1], p[2]), r);
+    return r;
+}
+
+/**
+ * Residuals of the joint homography refinement.
+ *
+ * Every match contributes the difference of its two points after mapping both into the
+ * reference frame. Each camera has 8 homography parameters, or 3 rotation parameters
+ * under the rotation model. The Jacobian is taken by central differences; the problem
+ * has at most a few dozen parameters and runs once per calibration.
+ */
+class HomographyRefineCallback : public cv::LMSolver::Callback {
+public:
+    HomographyRefineCallback(const std::vector<PairMatches> &pairs, int reference,
+                             const std::vector<cv::Matx33d> &intrinsics, bool rotation_only)
+        : pairs_(pairs), reference_(reference), intrinsics_(intrinsics), rotation_only_(rotation_only)
+    {
+        num_residuals_ = 0;
+        for (const PairMatches &pair : pairs_) {
+            num_residuals_ += 2 * static_cast<int>(pair.points_i.size());
+        }
+    }
+
+    bool compute(cv::InputArray param, cv::OutputArray err, cv::OutputArray J) const override
+    {
+        cv::Mat p = param.getMat();
+        err.create(num_residuals_, 1, CV_64F);
+        cv::Mat e = err.getMat();
+        residuals(p.ptr<double>(), e.ptr<double>());
+
+        if (J.needed()) {
+            J.create(num_residuals_, p.rows, CV_64F);
+            cv::Mat jac = J.getMat();
+            cv::Mat shifted = p.clone();
+            std::vector<double> plus(num_residuals_), minus(num_residuals_);
+            for (int k = 0; k < p.rows; k++) {
+                double value = p.at<double>(k);
+                double step = std::max(std::abs(value), 1e-3) * 1e-6;
+                shifted.at<double>(k) = value + step;
+                residuals(shifted.ptr<double>(), plus.data());
+                shifted.at<double>(k) = value - step;
+                residuals(shifted.ptr<double>(), minus.data());
+                shifted.at<double>(k) = value;
+                for (int r = 0; r < num_residuals_; r++) {
+                    jac.at<double>(r, k) = (plus[r] - minus[r]) / (2 * step);
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    cv::Matx33d homography(const double *p, int camera) const
+    {
+        if (camera == reference_) {
+            return cv::Matx33d::eye();
+        }
+        if (rotation_only_) {
+            cv::Matx33d r = rotation_from_params(p + 3 * param_slot(camera, reference_));
+            return intrinsics_[reference_] * r * intrinsics_[camera].inv();
+        }
+        return homography_from_params(p + 8 * param_slot(camera, reference_));
+    }
+
+    static cv::Point2d project(const cv::Matx33d &h, const cv::Point2f &pt)
+    {
+        cv::Vec3d q = h * cv::Vec3d(pt.x, pt.y, 1.0);
+        return cv::Point2d(q[0] / q[2], q[1] / q[2]);
+    }
+
+    void residuals(const double *p, double *out) const
+    {
+        int r = 0;
+        for (const PairMatches &pair : pairs_) {
+            cv::Matx33d hi = homography(p, pair.i);
+            cv::Matx33d hj = homography(p, pair.j);
+            for (size_t k = 0; k < pair.points_i.size(); k++) {
+                cv::Point2d d = project(hi, pair.points_i[k]) - project(hj, pair.points_j[k]);
+                out[r++] = d.x;
+                out[r++] = d.y;
+            }
+        }
+    }
+
+    const std::vector<PairMatches> &pairs_;
+    int reference_;
+    const std::vector<cv::Matx33d> &intrinsics_;
+    bool rotation_only_;
+    int num_residuals_;
+};
+
+/**
+ * Refines all homographies jointly over every pair of cameras that can be matched.
+ *
+ * Non-neighbouring pairs are only tried when their chained projections overlap. The
+ * reference camera stays fixed, which removes the global gauge freedom.
+ *
+ * @param images The calibration images.
+ * @param raw_images The raw frames the images were corrected from, or empty.
+ * @param reference The reference camera.
+ * @param calibration The calibration whose motion model and focal length are used.
+ * @param homographies The chained homographies on input, the refined ones on output.
+ * @param pairs The neighbouring pair matches; non-neighbouring pairs are appended.
+ */
+static void refine_homographies(const std::vector<cv::Mat> &images, const std::vector<cv::Mat> &raw_images, int reference,
+                                const PanoramaCalibration &calibration,
+                                std::vector<cv::Mat> &homographies, std::vector<PairMatches> &pairs)
+{
+    int n = static_cast<int>(images.size());
+    if (n < 2) {
+        return;
+    }
+
+    std::vector<cv::Rect> projected(n);
+    for (int i = 0; i < n; i++) {
+        std::vector<cv::Point2f> corners = {
+            cv::Point2f(0, 0), cv::Point2f(images[i].cols, 0),
+            cv::Point2f(images[i].cols, images[i].rows), cv::Point2f(0, images[i].rows)
+        };
+        cv::perspectiveTransform(corners, corners, homographies[i]);
+        projected[i] = cv::boundingRect(corners);
+    }
+
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 2; j < n; j++) {
+            if ((projected[i] & projected[j]).empty()) {
+                continue;
+            }
+            PairMatches pair;
+            pair.i = i;
+            pair.j = j;
+            cv::Mat h;
+            if (match_cameras(images, raw_images, calibration, h, pair) &&
+                static_cast<int>(pair.points_i.size()) >= PANORAMA_MIN_INLIERS) {
+                thin_matches(pair, PANORAMA_MAX_PAIR_POINTS);
+                pairs.push_back(pair);
+            }
+        }
+    }
+
+    // 旋转模型的参数是旋转向量，由 H = K_ref * R * K^-1 反推初值
+    bool rotation_only = calibration.motion_model == FUSION_MODEL_ROTATION;
+    int per_camera = rotation_only ? 3 : 8;
+    std::vector<cv::Matx33d> intrinsics(n);
+    for (int i = 0; i < n; i++) {
+        intrinsics[i] = camera_intrinsics(calibration.focal, images[i].size());
+    }
+
+    cv::Mat params(per_camera * (n - 1), 1, CV_64F);
+    for (int i = 0; i < n; i++) {
+        if (i == reference) {
+            continue;
+        }
+        double *p = params.ptr<double>() + per_camera * param_slot(i, reference);
+        if (rotation_only) {
+            cv::Matx33d r = intrinsics[reference].inv() * cv::Matx33d(homographies[i]) * intrinsics[i];
+            cv::Vec3d rvec;
+            cv::Rodrigues(r, rvec);
+            std::copy(rvec.val, rvec.val + 3, p);
+        } else {
+            const double *h = homographies[i].ptr<double>();
+            std::copy(h, h + 8, p);
+        }
+    }
+
+    cv::Ptr<cv::LMSolver::Callback> callback =
+        cv::makePtr<HomographyRefineCallback>(pairs, reference, intrinsics, rotation_only);
+    int iterations = cv::LMSolver::create(callback, PANORAMA_REFINE_ITERS)->run(params);
+    std::cout << "Refined " << n << " cameras over " << pairs.size()
+              << " camera pairs in " << iterations << " iterations." << std::endl;
+
+    for (int i = 0; i < n; i++) {
+        if (i == reference) {
+            continue;
+        }
+        const double *p = params.ptr<double>() + per_camera * param_slot(i, reference);
+        cv::Matx33d h = rotation_only ? intrinsics[reference] * rotation_from_params(p) * intrinsics[i].inv()
+                                      : homography_from_params(p);
+        homographies[i] = normalize_homography(cv::Mat(h));
+    }
+}
+
+// 画布坐标（平移前）-> 参考坐标系中的视线方向；平面投影时即参考像平面上的齐次坐标
+static inline cv::Vec3d canvas_to_ray(PanoramaProjection projection, double scale, double u, double v)
+{
+    switch (projection) {
+    case PANORAMA_PROJECTION_CYLINDRICAL: {
+        double theta = u / scale;
+        return cv::Vec3d(std::sin(theta), v / scale, std::cos(theta));
+    }
+    case PANORAMA_PROJECTION_SPHERICAL: {
+        double theta = u / scale;
+        double phi = v / scale;
+        return cv::Vec3d(std::sin(theta) * std::cos(phi), std::sin(phi), std::cos(theta) * std::cos(phi));
+    }
+    default:
+        return cv::Vec3d(u, v, 1.0);
+    }
+}
+
+// 视线方向的经度，取 (theta_ref - π, theta_ref + π] 内的值：atan2 在 ±π 处跳变，
+// 跨过该处的相机以自身中心经度为 theta_ref 展开，边界才保持连续
+static inline double ray_longitude(const cv::Vec3d &ray, double theta_ref)
+{
+    return theta_ref + std::remainder(std::atan2(ray[0], ray[2]) - theta_ref, 2 * CV_PI);
+}
+
+// 参考坐标系中的视线方向 -> 画布坐标（平移前），canvas_to_ray() 的逆；
+// 曲面投影的经度按 theta_ref 展开
+static inline cv::Point2d ray_to_canvas(PanoramaProjection projection, double scale, const cv::Vec3d &ray,
+                                        double theta_ref = 0)
+{
+    switch (projection) {
+    case PANORAMA_PROJECTION_CYLINDRICAL:
+        return cv::Point2d(scale * ray_longitude(ray, theta_ref), scale * ray[1] / std::hypot(ray[0], ray[2]));
+    case PANORAMA_PROJECTION_SPHERICAL:
+        return cv::Point2d(scale * ray_longitude(ray, theta_ref),
+                           scale * std::atan2(ray[1], std::hypot(ray[0], ray[2])));
+    default:
+        return cv::Point2d(ray[0] / ray[2], ray[1] / ray[2]);
+    }
+}
+
+// 相机像素 -> 参考方向的矩阵：平面投影为单应矩阵，曲面投影为 R * K^-1
+static cv::Matx33d camera_to_reference(const PanoramaCalibration &calibration, const PanoramaCamera &camera)
+{
+    if (calibration.projection == PANORAMA_PROJECTION_PLANE) {
+        return cv::Matx33d(camera.homography);
+    }
+    return camera.rotation * camera.intrinsics.inv();
+}
+
+/**
+ * Estimates a common focal length from the neighbouring homographies.
+ *
+ * Each homography is re-expressed with the principal points at the image centres and
+ * passed to cv::detail::focalsFromHomography(); the median of the pair estimates is used.
+ *
+ * @param images The calibration images.
+ * @param homographies The camera -> reference homographies.
+ * @return The focal length in pixels, or 0 if no pair gave an estimate.
+ */
+static double estimate_focal(const std::vector<cv::Mat> &images, const std::vector<cv::Mat> &homographies)
+{
+    std::vector<double> focals;
+    for (size_t i = 0; i + 1 < images.size(); i++) {
+        cv::Mat to_centre = (cv::Mat_<double>(3, 3) << 1, 0, -images[i].cols * 0.5, 0, 1, -images[i].rows * 0.5, 0, 0, 1);
+        cv::Mat from_centre = (cv::Mat_<double>(3, 3) << 1, 0, images[i + 1].cols * 0.5, 0, 1, images[i + 1].rows * 0.5, 0, 0, 1);
+        // 相机 i + 1 -> 相机 i
+        cv::Mat h = to_centre * homographies[i].inv() * homographies[i + 1] * from_centre;
+
+        double f0, f1;
+        bool f0_ok, f1_ok;
+        cv::detail::focalsFromHomography(h, f0, f1, f0_ok, f1_ok);
+        if (f0_ok && f1_ok) {
+            focals.push_back(std::sqrt(f0 * f1));
+        }
+    }
+    if (focals.empty()) {
+        return 0;
+    }
+    std::nth_element(focals.begin(), focals.begin() + focals.size() / 2, focals.end());
+    return focals[focals.size() / 2];
+}
+
+// 由单应矩阵 H = K_ref * R * K^-1 恢复旋转，再用 SVD 投影到最近的正交矩阵
+static cv::Matx33d rotation_from_homography(const cv::Mat &homography, const cv::Matx33d &k, const cv::Matx33d &k_ref)
+{
+    cv::Matx33d r = k_ref.inv() * cv::Matx33d(homography) * k;
+    cv::SVD svd(cv::Mat(r), cv::SVD::FULL_UV);
+    cv::Mat orthogonal = svd.u * svd.vt;
+    if (cv::determinant(orthogonal) < 0) {
+        orthogonal = -orthogonal;
+    }
+    return cv::Matx33d(orthogonal);
+}
+
+// 相机光轴方向的经度，不做展开
+static double camera_longitude(const PanoramaCalibration &calibration, const PanoramaCamera &camera)
+{
+    cv::Vec3d centre(camera.input_size.width * 0.5, camera.input_size.height * 0.5, 1);
+    return ray_longitude(camera_to_reference(calibration, camera) * centre, 0);
+}
+
+// 相机边界上的采样点投影到画布（平移前）的外接矩形，曲面投影下边界是曲线，逐点采样；
+// theta_ref 为相机展开后的中心经度
+static cv::Rect projected_bounds(const PanoramaCalibration &calibration, const PanoramaCamera &camera,
+                                 double theta_ref)
+{
+    const int samples = 32;
+    cv::Matx33d to_ref = camera_to_reference(calibration, camera);
+    std::vector<cv::Point2f> points;
+    for (int k = 0; k <= samples; k++) {
+        double tx = camera.input_size.width * static_cast<double>(k) / samples;
+        double ty = camera.input_size.height * static_cast<double>(k) / samples;
+        cv::Vec3d border[4] = {
+            cv::Vec3d(tx, 0, 1), cv::Vec3d(tx, camera.input_size.height, 1),
+            cv::Vec3d(0, ty, 1), cv::Vec3d(camera.input_size.width, ty, 1)
+        };
+        for (const cv::Vec3d &p : border) {
+            cv::Point2d q = ray_to_canvas(calibration.projection, calibration.scale, to_ref * p, theta_ref);
+            points.push_back(cv::Point2f(static_cast<float>(q.x), static_cast<float>(q.y)));
+        }
+    }
+    return cv::boundingRect(points);
+}
+
+/**
+ * Builds a camera's fixed-point remap tables and validity mask over its canvas rectangle.
+ *
+ * Each canvas pixel is turned into a viewing ray of the selected projection and mapped
+ * back into the camera once here, so the per-frame warp is the shared table sampler
+ * (apply_warp_maps()) whatever the projection.
+ *
+ * @param calibration The calibration holding the projection and scale.
+ * @param camera The camera; rect and its projection parameters must be set.
+ * @param shift The translation from projected coordinates to canvas coordinates.
+ */
+static void build_camera_maps(const PanoramaCalibration &calibration, PanoramaCamera &camera, const cv::Point &shift)
+{
+    const cv::Rect &rect = camera.rect;
+    cv::Matx33d from_ref = camera_to_reference(calibration, camera).inv();
+
+    cv::Mat map_x(rect.size(), CV_32F), map_y(rect.size(), CV_32F);
+    cv::parallel_for_(cv::Range(0, rect.height), [&](const cv::Range &range) {
+        for (int y = range.start; y < range.end; y++) {
+            float *mx = map_x.ptr<float>(y);
+            float *my = map_y.ptr<float>(y);
+            double v = y + rect.y - shift.y;
+            for (int x = 0; x < rect.width; x++) {
+                double u = x + rect.x - shift.x;
+                cv::Vec3d q = from_ref * canvas_to_ray(calibration.projection, calibration.scale, u, v);
+                // 落在相机背后的点无效
+                if (q[2] <= 0) {
+                    mx[x] = my[x] = -1.0f;
+                    continue;
+                }
+                mx[x] = static_cast<float>(q[0] / q[2]);
+                my[x] = static_cast<float>(q[1] / q[2]);
+            }
+        }
+    });
+
+    build_warp_maps(map_x, map_y, camera.input_size, camera.maps);
+}
+
+// 把所有相机的 rect 缓冲按行条带拆成一个并行范围。按相机并行时内层 remap/LUT 的
+// parallel_for_ 会被串行执行，相机数少于核数时用不满所有线程
+static void for_each_camera_stripe(const PanoramaCalibration &calibration,
+                                   const std::function<void(int, const cv::Range &)> &body)
+{
+    std::vector<cv::Point> items;  // (相机, 条带起始行)
+    for (size_t i = 0; i < calibration.cameras.size(); i++) {
+        for (int y = 0; y < calibration.cameras[i].rect.height; y += PANORAMA_STRIPE_ROWS) {
+            items.emplace_back(static_cast<int>(i), y);
+        }
+    }
+    cv::parallel_for_(cv::Range(0, static_cast<int>(items.size())), [&](const cv::Range &range) {
+        for (int k = range.start; k < range.end; k++) {
+            int i = items[k].x;
+            int y = items[k].y;
+            body(i, cv::Range(y, std::min(y + PANORAMA_STRIPE_ROWS, calibration.cameras[i].rect.height)));
+        }
+    });
+}
+
+// 所有相机变换到各自的 rect 缓冲，按 (相机, 行条带) 并行
+static void warp_cameras(const std::vector<cv::Mat> &images, PanoramaCalibration &calibration)
+{
+    for (size_t i = 0; i < images.size(); i++) {
+        PanoramaCamera &camera = calibration.cameras[i];
+        camera.warped.create(camera.maps.size(), images[i].type());
+    }
+    for_each_camera_stripe(calibration, [&](int i, const cv::Range &rows) {
+        PanoramaCamera &camera = calibration.cameras[i];
+        apply_warp_maps(images[i], camera.maps, rows, camera.warped);
+    });
+}
+
+/**
+ * Updates the per-camera gains from the overlaps of all seams at once.
+ *
+ * Solves the usual least-squares gain problem per channel: neighbouring cameras should
+ * agree in their common overlap and every gain is pulled towards 1, weighted by overlap
+ * size. New gains are blended in with weight alpha; a camera's lookup table is only
+ * rebuilt when its smoothed gain actually moves.
+ *
+ * @param calibration The calibration; the cameras' warped buffers must be uncompensated.
+ * @param step The sampling step in the overlaps.
+ * @param alpha The smoothing weight of the new estimate, 1 replaces the old gains.
+ */
+static void update_gains(PanoramaCalibration &calibration, int step, float alpha)
+{
+    int n = static_cast<int>(calibration.cameras.size());
+    const double inv_n2 = 1.0 / (PANORAMA_GAIN_SIGMA_N * PANORAMA_GAIN_SIGMA_N);
+    const double inv_g2 = 1.0 / (PANORAMA_GAIN_SIGMA_G * PANORAMA_GAIN_SIGMA_G);
+
+    std::vector<cv::Vec3d> means_first(calibration.seams.size()), means_second(calibration.seams.size());
+    std::vector<double> weights(calibration.seams.size(), 0.0);
+    for (size_t s = 0; s < calibration.seams.size(); s++) {
+        const PanoramaSeam &seam = calibration.seams[s];
+        const PanoramaCamera &first = calibration.cameras[seam.first];
+        const PanoramaCamera &second = calibration.cameras[seam.second];
+        cv::Mat overlap_first = first.warped(seam.overlap_rect - first.rect.tl());
+        cv::Mat overlap_second = second.warped(seam.overlap_rect - second.rect.tl());
+        if (overlap_channel_means(overlap_second, overlap_first, seam.mask, step,
+                                  means_second[s], means_first[s])) {
+            weights[s] = static_cast<double>(seam.overlap_rect.area()) / (step * step);
+        }
+    }
+
+    for (int c = 0; c < 3; c++) {
+        // 每个增益都有偏向 1 的先验，没有接缝的相机也不会奇异
+        cv::Mat A = cv::Mat::eye(n, n, CV_64F) * inv_g2;
+        cv::Mat b = cv::Mat::ones(n, 1, CV_64F) * inv_g2;
+        for (size_t s = 0; s < calibration.seams.size(); s++) {
+            if (weights[s] <= 0) {
+                continue;
+            }
+            int i = calibration.seams[s].first;
+            int j = calibration.seams[s].second;
+            double mi = means_first[s][c], mj = means_second[s][c], w = weights[s];
+            A.at<double>(i, i) += w * (mi * mi * inv_n2 + inv_g2);
+            A.at<double>(j, j) += w * (mj * mj * inv_n2 + inv_g2);
+            A.at<double>(i, j) -= w * mi * mj * inv_n2;
+            A.at<double>(j, i) -= w * mi * mj * inv_n2;
+            b.at<double>(i) += w * inv_g2;
+            b.at<double>(j) += w * inv_g2;
+        }
+
+        cv::Mat gains;
+        if (!cv::solve(A, b, gains, cv::DECOMP_CHOLESKY)) {
+            continue;
+        }
+        for (int i = 0; i < n; i++) {
+            float g = std::clamp(static_cast<float>(gains.at<double>(i)), FUSION_GAIN_MIN, FUSION_GAIN_MAX);
+            calibration.cameras[i].gain[c] += alpha * (g - calibration.cameras[i].gain[c]);
+        }
+    }
+
+    for (PanoramaCamera &camera : calibration.cameras) {
+        update_gain_lut(camera.gain, calibration.row_kernels->channels, camera.lut_gain, camera.gain_lut);
+    }
+}
+
+/**
+ * Calibrates a multi-camera rig: homographies, canvas, remap tables, seams and gains.
+ *
+ * For cylindrical and spherical projection the homographies are turned into a common
+ * focal length and per-camera rotations, and the canvas is parameterised by angle.
+ * Longitudes are unrolled along the rig order, so cameras across the ±180° direction stay
+ * contiguous; rigs covering 360° or more are rejected, the canvas does not wrap around.
+ *
+ * @param images One calibration image per camera, in rig order, all in the layout of
+ *               calibration.output_format (see to_pixel_layout()).
+ * @param calibration Receives the geometry. Caller settings (mode, projection, focal,
+ *                    reference, gain compensation, output format) are kept.
+ * @param raw_images Optional raw frames the images were lens-corrected from, one per
+ *                   camera. When given, features are detected on them instead.
+ * @return True if every camera could be placed on the canvas, false otherwise.
+ */
+bool calibrate_panorama(const std::vector<cv::Mat> &images, PanoramaCalibration &calibration,
+                        const std::vector<cv::Mat> &raw_images)
+{
+    calibration.valid = false;
+
+    int n = static_cast<int>(images.size());
+    if (n < 2) {
+        std::cerr << "At least two cameras are needed for a panorama." << std::endl;
+        return false;
+    }
+
+    // 画布的像素布局由输出格式决定，输入须已转换到该布局
+    PixelLayout layout;
+    if (!output_pixel_layout(calibration.output_format, layout)) {
+        return false;
+    }
+    const PixelRowKernels &kernels = pixel_row_kernels(layout);
+    for (int i = 0; i < n; i++) {
+        if (images[i].type() != CV_8UC(kernels.channels)) {
+            std::cerr << "Input image " << i << " does not match the " << kernels.channels
+                      << "-channel output layout." << std::endl;
+            return false;
+        }
+    }
+    if (!raw_images.empty()) {
+        bool matches = raw_images.size() == images.size();
+        for (int i = 0; matches && i < n; i++) {
+            matches = lens_corrected_size(raw_images[i].size()) == images[i].size();
+        }
+        if (!matches) {
+            std::cerr << "Raw frames do not match the corrected images." << std::endl;
+            return false;
+        }
+    }
+    int reference = calibration.reference >= 0 && calibration.reference < n ? calibration.reference : n / 2;
+    if (calibration.motion_model == FUSION_MODEL_ROTATION && calibration.focal <= 0) {
+        std::cerr << "The rotation model needs PanoramaCalibration::focal." << std::endl;
+        return false;
+    }
+
+    std::vector<cv::Mat> homographies;
+    std::vector<PairMatches> pairs;
+    if (!chain_homographies(images, raw_images, reference, calibration, homographies, pairs)) {
+        return false;
+    }
+    if (calibration.mode == PANORAMA_CALIB_GLOBAL) {
+        refine_homographies(images, raw_images, reference, calibration, homographies, pairs);
+    }
+
+    calibration.cameras.assign(n, PanoramaCamera());
+    for (int i = 0; i < n; i++) {
+        calibration.cameras[i].input_size = images[i].size();
+        calibration.cameras[i].homography = homographies[i];
+    }
+
+    // 曲面投影：由单应矩阵得到公共焦距和每个相机相对参考相机的旋转
+    calibration.scale = 1.0;
+    if (calibration.projection != PANORAMA_PROJECTION_PLANE) {
+        double focal = calibration.focal > 0 ? calibration.focal : estimate_focal(images, homographies);
+        if (focal <= 0) {
+            std::cerr << "Could not estimate the focal length, set PanoramaCalibration::focal." << std::endl;
+            return false;
+        }
+        calibration.scale = focal;
+        cv::Matx33d k_ref = camera_intrinsics(focal, images[reference].size());
+        for (PanoramaCamera &camera : calibration.cameras) {
+            camera.intrinsics = camera_intrinsics(focal, camera.input_size);
+            camera.rotation = rotation_from_homography(camera.homography, camera.intrinsics, k_ref);
+        }
+    }
+
+    // 曲面投影的经度沿相机顺序从参考相机向两侧展开，相邻相机的中心经度相差不超过 π，
+    // 跨过 ±180° 的相机不会折回画布另一端
+    std::vector<double> longitudes(n, 0.0);
+    if (calibration.projection != PANORAMA_PROJECTION_PLANE) {
+        for (int i = reference + 1; i < n; i++) {
+            longitudes[i] = longitudes[i - 1] +
+                std::remainder(camera_longitude(calibration, calibration.cameras[i]) - longitudes[i - 1], 2 * CV_PI);
+        }
+        for (int i = reference - 1; i >= 0; i--) {
+            longitudes[i] = longitudes[i + 1] +
+                std::remainder(camera_longitude(calibration, calibration.cameras[i]) - longitudes[i + 1], 2 * CV_PI);
+        }
+    }
+
+    // 画布 = 所有相机投影范围的并集，平移到原点
+    cv::Rect union_rect;
+    double total_area = 0;
+    for (int i = 0; i < n; i++) {
+        PanoramaCamera &camera = calibration.cameras[i];
+        camera.rect = projected_bounds(calibration, camera, longitudes[i]);
+        union_rect = i == 0 ? camera.rect : (union_rect | camera.rect);
+        total_area += images[i].total();
+    }
+    if (union_rect.area() <= 0 || union_rect.area() > FUSION_MAX_CANVAS_RATIO * total_area) {
+        std::cerr << "Degenerate projection, canvas size " << union_rect.size() << "." << std::endl;
+        return false;
+    }
+    // 覆盖满 360° 的环形相机组需要首尾相接的画布，这里不支持：展开后同一方向会在画布上出现两次
+    if (calibration.projection != PANORAMA_PROJECTION_PLANE && union_rect.width >= 2 * CV_PI * calibration.scale) {
+        std::cerr << "The rig spans 360 degrees or more, which a flat panorama canvas cannot hold." << std::endl;
+        return false;
+    }
+    cv::Point shift = -union_rect.tl();
+    calibration.canvas_size = union_rect.size();
+
+    // 每个相机的重映射表只和几何有关，标定时计算一次
+    for (PanoramaCamera &camera : calibration.cameras) {
+        camera.rect += shift;
+        build_camera_maps(calibration, camera, shift);
+    }
+    warp_cameras(images, calibration);
+
+    // 相邻相机之间在标定帧上找接缝，后写入的相机在画布上，前一个相机沿接缝混入
+    calibration.seam_band = FUSION_SEAM_BAND;
+    calibration.row_kernels = &kernels;
+    calibration.seams.clear();
+    for (int i = 0; i + 1 < n; i++) {
+        const PanoramaCamera &first = calibration.cameras[i];
+        const PanoramaCamera &second = calibration.cameras[i + 1];
+        PanoramaSeam seam;
+        seam.first = i;
+        seam.second = i + 1;
+        seam.overlap_rect = first.rect & second.rect;
+        if (seam.overlap_rect.empty()) {
+            continue;
+        }
+        seam.mask = first.maps.mask(seam.overlap_rect - first.rect.tl()) & second.maps.mask(seam.overlap_rect - second.rect.tl());
+        seam.first_on_right = (first.rect.x + first.rect.width / 2) >= (second.rect.x + second.rect.width / 2);
+        find_seam(second.warped(seam.overlap_rect - second.rect.tl()), first.warped(seam.overlap_rect - first.rect.tl()),
+                  seam.mask, seam.seam);
+        build_seam_ramp(seam.overlap_rect.width, calibration.seam_band, seam.first_on_right, seam.ramp);
+        calibration.seams.push_back(seam);
+    }
+
+    // 用标定帧的重叠区估计初始增益
+    update_gains(calibration, 2, 1.0f);
+
+    std::cout << "Panorama canvas size: " << calibration.canvas_size << ", " << n << " cameras, reference "
+              << reference << ", " << calibration.seams.size() << " seams, pixel kernels: "
+              << pixel_kernels().name << std::endl;
+
+    calibration.valid = true;
+    return true;
+}
+
+// 合成画布的一行：按相机顺序写入，每写入一个相机就把前一相机沿两者的接缝混入
+static void compose_row(const PanoramaCalibration &calibration, int y, uchar *dst)
+{
+    const PixelRowKernels &kernels = *calibration.row_kernels;
+    int cn = kernels.channels;
+    std::memset(dst, 0, cn * static_cast<size_t>(calibration.canvas_size.width));
+    for (size_t i = 0; i < calibration.cameras.size(); i++) {
+        const PanoramaCamera &camera = calibration.cameras[i];
+        const cv::Rect &r = camera.rect;
+        if (y >= r.y && y < r.y + r.height) {
+            kernels.copy[1][0](camera.warped.ptr<uchar>(y - r.y), camera.maps.mask.ptr<uchar>(y - r.y), nullptr,
+                              dst + cn * r.x, r.width);
+        }
+
+        for (const PanoramaSeam &seam : calibration.seams) {
+            const cv::Rect &o = seam.overlap_rect;
+            if (seam.second != static_cast<int>(i) || y < o.y || y >= o.y + o.height) {
+                continue;
+            }
+            const PanoramaCamera &first = calibration.cameras[seam.first];
+            const uchar *src = first.warped.ptr<uchar>(y - first.rect.y) + cn * (o.x - first.rect.x);
+            seam_blend_span(kernels, src, seam.mask.ptr<uchar>(y - o.y), dst + cn * o.x, 0, o.width,
+                            seam.seam[y - o.y], o.width, calibration.seam_band, seam.first_on_right,
+                            seam.ramp, nullptr, nullptr);
+        }
+    }
+}
+
+/**
+ * Stitches N camera frames into one panorama frame.
+ *
+ * Every camera is warped once, in parallel, through its precomputed remap tables; the
+ * canvas is then assembled row by row, blending along each seam between neighbouring
+ * cameras, and written straight into the output frame. GRAY8, BGR24 and BGRA rows are
+ * composited in place; YUV420P and NV12 rows are composited in BGR24 pairs and converted.
+ *
+ * @param frames One input frame per camera, in rig order.
+ * @param frame_fused The output frame; its buffer is reused while the canvas size is stable.
+ * @param is_correct Whether to correct the lens distortion of the inputs first.
+ * @param calibration Optional cached calibration, (re)computed when invalid or when the
+ *                    number or sizes of the inputs change. When null, every call calibrates.
+ * @return True if the panorama was produced, false otherwise.
+ */
+bool panorama_fusion(const std::vector<AVFrame *> &frames, AVFrame *frame_fused, bool is_correct,
+                     PanoramaCalibration *calibration)
+{
+    if (frames.size() < 2 || !frame_fused) {
+        return false;
+    }
+
+    // 没有传入缓存时每次都重新标定
+    PanoramaCalibration local_calibration;
+    PanoramaCalibration &calib = calibration ? *calibration : local_calibration;
+
+    // 画布按输出格式的像素布局合成，输入在校正后转换到该布局
+    PixelLayout layout;
+    if (!output_pixel_layout(calib.output_format, layout)) {
+        return false;
+    }
+    const PixelRowKernels &kernels = pixel_row_kernels(layout);
+
+    // 校正时保留原图，标定时在原图上检测特征点
+    std::vector<cv::Mat> images(frames.size());
+    std::vector<cv::Mat> raw_images;
+    for (size_t i = 0; i < frames.size(); i++) {
+        cv::Mat raw = frames[i] ? avframeToCvmat(frames[i]) : cv::Mat();
+        if (is_correct) {
+            raw_images.push_back(raw);
+        }
+        images[i] = to_pixel_layout(is_correct ? correct_lens(raw) : raw, kernels.channels);
+        if (images[i].empty()) {
+            std::cerr << "Input image " << i << " is empty." << std::endl;
+            return false;
+        }
+    }
+
+    // 相机数、尺寸或输出布局变化时重新标定
+    bool stale = !calib.valid || calib.cameras.size() != images.size() || calib.row_kernels != &kernels;
+    for (size_t i = 0; !stale && i < images.size(); i++) {
+        stale = calib.cameras[i].input_size != images[i].size();
+    }
+    if (stale && !calibrate_panorama(images, calib, raw_images)) {
+        return false;
+    }
+
+    warp_cameras(images, calib);
+
+    // 增益在补偿前的变换结果上抽样刷新，再原地查表
+    if (calib.gain_compensation) {
+        update_gains(calib, FUSION_GAIN_STEP, FUSION_GAIN_ALPHA);
+        for_each_camera_stripe(calib, [&](int i, const cv::Range &rows) {
+            PanoramaCamera &camera = calib.cameras[i];
+            cv::Mat stripe = camera.warped.rowRange(rows);
+            cv::LUT(stripe, camera.gain_lut, stripe);
+        });
+    }
+
+    AVPixelFormat format = calib.output_format;
+    if (!prepare_output_frame(frame_fused, calib.canvas_size, format)) {
+        std::cerr << "Could not allocate output frame." << std::endl;
+        return false;
+    }
+
+    // 按行对合成，GRAY8/BGR24/BGRA 直接写入输出平面，YUV 在两行 BGR24 缓冲上合成后转换
+    int width = calib.canvas_size.width;
+    int height = calib.canvas_size.height;
+    int cn = kernels.channels;
+    bool yuv = format == AV_PIX_FMT_YUV420P || format == AV_PIX_FMT_NV12;
+    cv::parallel_for_(cv::Range(0, (height + 1) / 2), [&](const cv::Range &range) {
+        std::vector<uchar> rows(yuv ? 2 * cn * static_cast<size_t>(width) : 0);
+        for (int k = range.start; k < range.end; k++) {
+            int y = 2 * k;
+            bool pair = y + 1 < height;
+            uchar *row0 = yuv ? rows.data() : frame_fused->data[0] + static_cast<ptrdiff_t>(y) * frame_fused->linesize[0];
+            uchar *row1 = yuv ? rows.data() + cn * width : row0 + frame_fused->linesize[0];
+            compose_row(calib, y, row0);
+            if (pair) {
+                compose_row(calib, y + 1, row1);
+            }
+            if (yuv) {
+                store_yuv420_rows(row0, pair ? row1 : nullptr, width, 0, y, frame_fused);
+            }
+        }
+    });
+
+    return true;
+}
@@ -0,0 +1,337 @@
+#include "../include/pixel_kernels.h"
+#include "../include/blend.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/hal/hal.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <cstring>
+
+// 通用版本：OpenCV 通用 intrinsics 按编译基线生成，非 x86 平台（NEON）和不支持 SSE4.2 的 CPU 使用
+namespace pixel_baseline {
+
+#if CV_SIMD
+// 按通道数载入、存储 CN 个通道平面
+static inline void load_channels(const uchar *p, cv::v_uint8 (&c)[1])
+{
+    c[0] = cv::vx_load(p);
+}
+
+static inline void load_channels(const uchar *p, cv::v_uint8 (&c)[3])
+{
+    cv::v_load_deinterleave(p, c[0], c[1], c[2]);
+}
+
+static inline void load_channels(const uchar *p, cv::v_uint8 (&c)[4])
+{
+    cv::v_load_deinterleave(p, c[0], c[1], c[2], c[3]);
+}
+
+static inline void store_channels(uchar *p, const cv::v_uint8 (&c)[1])
+{
+    cv::v_store(p, c[0]);
+}
+
+static inline void store_channels(uchar *p, const cv::v_uint8 (&c)[3])
+{
+    cv::v_store_interleave(p, c[0], c[1], c[2]);
+}
+
+static inline void store_channels(uchar *p, const cv::v_uint8 (&c)[4])
+{
+    cv::v_store_interleave(p, c[0], c[1], c[2], c[3]);
+}
+#endif
+
+template <int CN, bool MASKED>
+static void feather_blend_row(const uchar *src1, const uchar *src2, const uchar *mask2,
+                              const ushort *ramp, uchar *dst, int width)
+{
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::v_uint8::nlanes;
+    const int half = cv::v_uint16::nlanes;
+    cv::v_uint16 one = cv::vx_setall_u16(BLEND_WEIGHT_ONE);
+    cv::v_uint16 zero = cv::vx_setzero_u16();
+    for (; x <= width - lanes; x += lanes) {
+        // 权重：图像 2 无效的像素清零
+        cv::v_uint16 w_lo = cv::vx_load(ramp + x);
+        cv::v_uint16 w_hi = cv::vx_load(ramp + x + half);
+        if constexpr (MASKED) {
+            cv::v_uint16 m_lo, m_hi;
+            cv::v_expand(cv::vx_load(mask2 + x), m_lo, m_hi);
+            w_lo = w_lo & (m_lo > zero);
+            w_hi = w_hi & (m_hi > zero);
+        }
+        cv::v_uint16 iw_lo = one - w_lo;
+        cv::v_uint16 iw_hi = one - w_hi;
+
+        cv::v_uint8 a[CN], b[CN], out[CN];
+        load_channels(src1 + CN * x, a);
+        load_channels(src2 + CN * x, b);
+        for (int c = 0; c < CN; c++) {
+            cv::v_uint16 a_lo, a_hi, b_lo, b_hi;
+            cv::v_expand(a[c], a_lo, a_hi);
+            cv::v_expand(b[c], b_lo, b_hi);
+            // 最大 255 * 256，不会溢出 16 位
+            cv::v_uint16 s_lo = cv::v_mul_wrap(a_lo, iw_lo) + cv::v_mul_wrap(b_lo, w_lo);
+            cv::v_uint16 s_hi = cv::v_mul_wrap(a_hi, iw_hi) + cv::v_mul_wrap(b_hi, w_hi);
+            out[c] = cv::v_rshr_pack<8>(s_lo, s_hi);
+        }
+        store_channels(dst + CN * x, out);
+    }
+#endif
+    for (; x < width; x++) {
+        int w = (!MASKED || mask2[x]) ? ramp[x] : 0;
+        int iw = BLEND_WEIGHT_ONE - w;
+        for (int c = 0; c < CN; c++) {
+            dst[CN * x + c] = static_cast<uchar>((src1[CN * x + c] * iw + src2[CN * x + c] * w + 128) >> 8);
+        }
+    }
+}
+
+template <int CN, bool MASKED, bool LUT>
+static void copy_row(const uchar *src, const uchar *mask, const uchar *lut, uchar *dst, int width)
+{
+    if constexpr (!MASKED && !LUT) {
+        std::memcpy(dst, src, CN * static_cast<size_t>(width));
+        return;
+    }
+
+    int x = 0;
+#if CV_SIMD
+    // 无查表的掩码拷贝：逐通道按掩码选择
+    if constexpr (!LUT) {
+        const int lanes = cv::v_uint8::nlanes;
+        cv::v_uint8 zero = cv::vx_setzero_u8();
+        for (; x <= width - lanes; x += lanes) {
+            cv::v_uint8 take = cv::vx_load(mask + x) > zero;
+            cv::v_uint8 s[CN], d[CN];
+            load_channels(src + CN * x, s);
+            load_channels(dst + CN * x, d);
+            for (int c = 0; c < CN; c++) {
+                d[c] = cv::v_select(take, s[c], d[c]);
+            }
+            store_channels(dst + CN * x, d);
+        }
+    }
+#endif
+    for (; x < width; x++) {
+        if (MASKED && !mask[x]) {
+            continue;
+        }
+        for (int c = 0; c < CN; c++) {
+            dst[CN * x + c] = LUT ? lut[CN * src[CN * x + c] + c] : src[CN * x + c];
+        }
+    }
+}
+
+template <int CN>
+static constexpr PixelRowKernels row_kernels()
+{
+    return { CN,
+             { feather_blend_row<CN, false>, feather_blend_row<CN, true> },
+             { { copy_row<CN, false, false>, copy_row<CN, false, true> },
+               { copy_row<CN, true, false>, copy_row<CN, true, true> } } };
+}
+
+// BT.601 有限范围系数，Q8 定点：与 FFmpeg/SDL 默认的 YUV420P 解释一致
+static inline uchar bgr_to_y(int b, int g, int r)
+{
+    return static_cast<uchar>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+static inline uchar bgr_to_u(int b, int g, int r)
+{
+    return cv::saturate_cast<uchar>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+static inline uchar bgr_to_v(int b, int g, int r)
+{
+    return cv::saturate_cast<uchar>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+#if CV_SIMD
+// 相邻两像素求和：把 8 位向量按 16 位重新解释，低字节加高字节
+static inline cv::v_uint16 pair_sum(const cv::v_uint8 &x)
+{
+    cv::v_uint16 w = cv::v_reinterpret_as_u16(x);
+    return (w & cv::vx_setall_u16(0xFF)) + cv::v_shr<8>(w);
+}
+
+static inline cv::v_uint8 luma(const cv::v_uint8 &b, const cv::v_uint8 &g, const cv::v_uint8 &r)
+{
+    cv::v_uint16 b_lo, b_hi, g_lo, g_hi, r_lo, r_hi;
+    cv::v_expand(b, b_lo, b_hi);
+    cv::v_expand(g, g_lo, g_hi);
+    cv::v_expand(r, r_lo, r_hi);
+    cv::v_uint16 kr = cv::vx_setall_u16(66), kg = cv::vx_setall_u16(129), kb = cv::vx_setall_u16(25);
+    cv::v_uint16 bias = cv::vx_setall_u16(128);
+    // 最大 220 * 255 + 128，不会溢出 16 位
+    cv::v_uint16 y_lo = cv::v_mul_wrap(r_lo, kr) + cv::v_mul_wrap(g_lo, kg) + cv::v_mul_wrap(b_lo, kb) + bias;
+    cv::v_uint16 y_hi = cv::v_mul_wrap(r_hi, kr) + cv::v_mul_wrap(g_hi, kg) + cv::v_mul_wrap(b_hi, kb) + bias;
+    return cv::v_pack(cv::v_shr<8>(y_lo), cv::v_shr<8>(y_hi)) + cv::vx_setall_u8(16);
+}
+
+// 2x2 均值上的色度，系数和不超过 112 * 255，16 位有符号足够
+static inline cv::v_int16 chroma(const cv::v_int16 &b, const cv::v_int16 &g, const cv::v_int16 &r,
+                                 short kb, short kg, short kr)
+{
+    cv::v_int16 s = cv::v_mul_wrap(b, cv::vx_setall_s16(kb)) + cv::v_mul_wrap(g, cv::vx_setall_s16(kg)) +
+                    cv::v_mul_wrap(r, cv::vx_setall_s16(kr)) + cv::vx_setall_s16(128);
+    return cv::v_shr<8>(s) + cv::vx_setall_s16(128);
+}
+#endif
+
+static void bgr_to_yuv420_rows(const uchar *bgr0, const uchar *bgr1, int width,
+                               uchar *y0, uchar *y1, uchar *u, uchar *v, int uv_step)
+{
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::v_uint8::nlanes;
+    for (; x <= width - lanes; x += lanes) {
+        cv::v_uint8 b0, g0, r0, b1, g1, r1;
+        cv::v_load_deinterleave(bgr0 + 3 * x, b0, g0, r0);
+        cv::v_load_deinterleave(bgr1 + 3 * x, b1, g1, r1);
+        cv::v_store(y0 + x, luma(b0, g0, r0));
+        if (y1) {
+            cv::v_store(y1 + x, luma(b1, g1, r1));
+        }
+
+        // 2x2 块求和后取整到均值
+        cv::v_uint16 two = cv::vx_setall_u16(2);
+        cv::v_int16 b = cv::v_reinterpret_as_s16(cv::v_shr<2>(pair_sum(b0) + pair_sum(b1) + two));
+        cv::v_int16 g = cv::v_reinterpret_as_s16(cv::v_shr<2>(pair_sum(g0) + pair_sum(g1) + two));
+        cv::v_int16 r = cv::v_reinterpret_as_s16(cv::v_shr<2>(pair_sum(r0) + pair_sum(r1) + two));
+        cv::v_uint8 u_vec = cv::v_pack_u(chroma(b, g, r, 112, -74, -38), chroma(b, g, r, 112, -74, -38));
+        cv::v_uint8 v_vec = cv::v_pack_u(chroma(b, g, r, -18, -94, 112), chroma(b, g, r, -18, -94, 112));
+        int cx = x / 2;
+        if (uv_step == 1) {
+            cv::v_store_low(u + cx, u_vec);
+            cv::v_store_low(v + cx, v_vec);
+        } else {
+            cv::v_uint8 uv_lo, uv_hi;
+            cv::v_zip(u_vec, v_vec, uv_lo, uv_hi);
+            cv::v_store(u + 2 * cx, uv_lo);
+        }
+    }
+#endif
+    for (; x < width; x++) {
+        const uchar *p0 = bgr0 + 3 * x;
+        const uchar *p1 = bgr1 + 3 * x;
+        y0[x] = bgr_to_y(p0[0], p0[1], p0[2]);
+        if (y1) {
+            y1[x] = bgr_to_y(p1[0], p1[1], p1[2]);
+        }
+        if (x & 1) {
+            continue;
+        }
+
+        // 奇数宽度的最后一列只有一对像素
+        int n = x + 1 < width ? 2 : 1;
+        int sum[3];
+        for (int c = 0; c < 3; c++) {
+            sum[c] = p0[c] + p1[c] + (n == 2 ? p0[3 + c] + p1[3 + c] : 0);
+        }
+        int b = (sum[0] + n) / (2 * n), g = (sum[1] + n) / (2 * n), r = (sum[2] + n) / (2 * n);
+        u[(x / 2) * uv_step] = bgr_to_u(b, g, r);
+        v[(x / 2) * uv_step] = bgr_to_v(b, g, r);
+    }
+}
+
+static int dot_int8(const schar *a, const schar *b, int len)
+{
+    int i = 0;
+    int sum = 0;
+#if CV_SIMD
+    // int8 扩展为 int16 后用 v_dotprod 做乘加
+    cv::v_int32 acc = cv::vx_setzero_s32();
+    for (; i <= len - cv::v_int16::nlanes; i += cv::v_int16::nlanes) {
+        cv::v_int16 va = cv::vx_load_expand(a + i);
+        cv::v_int16 vb = cv::vx_load_expand(b + i);
+        acc = acc + cv::v_dotprod(va, vb);
+    }
+    sum = cv::v_reduce_sum(acc);
+#endif
+    for (; i < len; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+static int hamming_u8(const uchar *a, const uchar *b, int len)
+{
+    int i = 0;
+    int sum = 0;
+#if CV_SIMD
+    // 按字节计数后逐级扩展到 uint32 向量累加，循环结束后只归约一次
+    cv::v_uint32 acc = cv::vx_setzero_u32();
+    for (; i <= len - cv::v_uint8::nlanes; i += cv::v_uint8::nlanes) {
+        cv::v_uint8 bits = cv::v_popcount(cv::vx_load(a + i) ^ cv::vx_load(b + i));
+        cv::v_uint16 lo, hi;
+        cv::v_expand(bits, lo, hi);
+        cv::v_uint32 lo32, hi32;
+        cv::v_expand(lo + hi, lo32, hi32);
+        acc += lo32 + hi32;
+    }
+    sum = static_cast<int>(cv::v_reduce_sum(acc));
+#endif
+    if (i < len) {
+        sum += cv::hal::normHamming(a + i, b + i, len - i);
+    }
+    return sum;
+}
+
+const PixelKernels kernels = {
+    "baseline",
+    { row_kernels<1>(), row_kernels<3>(), row_kernels<4>() },
+    bgr_to_yuv420_rows,
+    dot_int8,
+    hamming_u8
+};
+
+} // namespace pixel_baseline
+
+// 按 CPUID 选择可用的最高版本。cv::checkHardwareSupport 同时检查操作系统是否保存了
+// AVX 寄存器状态，并遵循 OPENCV_CPU_DISABLE 环境变量，可用来强制较低的版本做对比
+static const PixelKernels &select_pixel_kernels()
+{
+    const PixelKernels *kernels = &pixel_baseline::kernels;
+#ifdef FUSION_PIXEL_KERNELS_X86
+    if (cv::checkHardwareSupport(CV_CPU_AVX512_SKX)) {
+        kernels = &pixel_avx512::kernels;
+    } else if (cv::checkHardwareSupport(CV_CPU_AVX2) && cv::checkHardwareSupport(CV_CPU_FMA3)) {
+        kernels = &pixel_avx2::kernels;
+    } else if (cv::checkHardwareSupport(CV_CPU_SSE4_2) && cv::checkHardwareSupport(CV_CPU_POPCNT)) {
+        kernels = &pixel_sse42::kernels;
+    }
+#endif
+    return *kernels;
+}
+
+/**
+ * Returns the pixel kernels selected for this CPU.
+ *
+ * The variant is chosen once, on first use, from the CPU features reported by OpenCV;
+ * every later call returns the same table. Its name field tells which one was picked.
+ *
+ * @return The kernel table.
+ */
+const PixelKernels &pixel_kernels()
+{
+    static const PixelKernels &kernels = select_pixel_kernels();
+    return kernels;
+}
+
+/**
+ * Returns the row kernels of one pixel layout in the selected instruction-set variant.
+ *
+ * @param layout The pixel layout.
+ * @return The kernels; callers keep the reference for the whole session.
+ */
+const PixelRowKernels &pixel_row_kernels(PixelLayout layout)
+{
+    return pixel_kernels().rows[layout];
+}
+
+// 库加载时即完成选择，不把首次调用的开销留到第一帧
+[[maybe_unused]] static const PixelKernels &pixel_kernels_at_load = pixel_kernels();
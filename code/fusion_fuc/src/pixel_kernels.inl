@@ -0,0 +1,200 @@
+// 像素内核的可移植实现，由 pixel_kernels_sse42.cpp、pixel_kernels_avx2.cpp、pixel_kernels_avx512.cpp
+// 以各自的指令集选项各包含一次，向量化交给编译器。
+//
+// 除 pixel_kernels.h 外不包含任何头文件：以不同指令集编译的内联函数在链接时会被合并成一份，
+// 旧 CPU 上可能执行到新指令。这里所有函数都是 static，只在本翻译单元内可见。
+// 结果与 pixel_kernels.cpp 中的通用版本逐位一致。
+
+#include "../include/pixel_kernels.h"
+
+#ifndef PIXEL_KERNEL_NAMESPACE
+#error "Define PIXEL_KERNEL_NAMESPACE and PIXEL_KERNEL_NAME before including pixel_kernels.inl"
+#endif
+
+namespace PIXEL_KERNEL_NAMESPACE {
+
+// 每块处理的像素数：块内数据放在局部缓冲里，内层循环没有指针别名，编译器可以完整向量化
+static const int PIXEL_CHUNK = 64;
+
+// 定点权重的满值，与 blend.h 中的 BLEND_WEIGHT_ONE 一致
+static const int PIXEL_WEIGHT_ONE = 256;
+
+static inline int min_int(int a, int b)
+{
+    return a < b ? a : b;
+}
+
+static inline unsigned char clamp_u8(int x)
+{
+    return static_cast<unsigned char>(x < 0 ? 0 : (x > 255 ? 255 : x));
+}
+
+// 混合 CN 通道的一行，dst 可以与 src1 或 src2 相同
+template <int CN, bool MASKED>
+static void feather_blend_row(const unsigned char *src1, const unsigned char *src2, const unsigned char *mask2,
+                              const unsigned short *ramp, unsigned char *dst, int width)
+{
+    unsigned char a[CN * PIXEL_CHUNK], b[CN * PIXEL_CHUNK], out[CN * PIXEL_CHUNK];
+    unsigned short w[PIXEL_CHUNK];
+
+    for (int x0 = 0; x0 < width; x0 += PIXEL_CHUNK) {
+        int n = min_int(width - x0, PIXEL_CHUNK);
+        __builtin_memcpy(a, src1 + CN * x0, CN * n);
+        __builtin_memcpy(b, src2 + CN * x0, CN * n);
+        if constexpr (MASKED) {
+            // 用位掩码代替分支，循环保持可向量化
+            for (int i = 0; i < n; i++) {
+                w[i] = ramp[x0 + i] & static_cast<unsigned short>(-(mask2[x0 + i] != 0));
+            }
+        } else {
+            __builtin_memcpy(w, ramp + x0, n * sizeof(unsigned short));
+        }
+
+        for (int i = 0; i < n; i++) {
+            int wi = w[i];
+            int iw = PIXEL_WEIGHT_ONE - wi;
+            for (int c = 0; c < CN; c++) {
+                out[CN * i + c] = static_cast<unsigned char>((a[CN * i + c] * iw + b[CN * i + c] * wi + 128) >> 8);
+            }
+        }
+        __builtin_memcpy(dst + CN * x0, out, CN * n);
+    }
+}
+
+// 拷贝 CN 通道的一行；未被掩码覆盖的像素保持原值
+template <int CN, bool MASKED, bool LUT>
+static void copy_row(const unsigned char *__restrict src, const unsigned char *__restrict mask,
+                     const unsigned char *__restrict lut, unsigned char *__restrict dst, int width)
+{
+    if constexpr (LUT) {
+        // 查表是逐字节的间接访问，没有可用的向量形式
+        for (int x = 0; x < width; x++) {
+            if (MASKED && !mask[x]) {
+                continue;
+            }
+            for (int c = 0; c < CN; c++) {
+                dst[CN * x + c] = lut[CN * src[CN * x + c] + c];
+            }
+        }
+    } else if constexpr (MASKED) {
+        // 写回原值代替条件写入，按位选择，循环可以向量化
+        for (int x = 0; x < width; x++) {
+            unsigned char take = static_cast<unsigned char>(-(mask[x] != 0));
+            for (int c = 0; c < CN; c++) {
+                dst[CN * x + c] = static_cast<unsigned char>((src[CN * x + c] & take) | (dst[CN * x + c] & ~take));
+            }
+        }
+    } else {
+        __builtin_memcpy(dst, src, CN * width);
+    }
+}
+
+template <int CN>
+static constexpr PixelRowKernels row_kernels()
+{
+    return { CN,
+             { feather_blend_row<CN, false>, feather_blend_row<CN, true> },
+             { { copy_row<CN, false, false>, copy_row<CN, false, true> },
+               { copy_row<CN, true, false>, copy_row<CN, true, true> } } };
+}
+
+// BT.601 有限范围，Q8 定点
+static void luma_row(const unsigned char *__restrict bgr, unsigned char *__restrict y, int width)
+{
+    for (int x = 0; x < width; x++) {
+        int b = bgr[3 * x], g = bgr[3 * x + 1], r = bgr[3 * x + 2];
+        y[x] = static_cast<unsigned char>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    }
+}
+
+static void bgr_to_yuv420_rows(const unsigned char *bgr0, const unsigned char *bgr1, int width,
+                               unsigned char *y0, unsigned char *y1, unsigned char *u, unsigned char *v,
+                               int uv_step)
+{
+    luma_row(bgr0, y0, width);
+    if (y1) {
+        luma_row(bgr1, y1, width);
+    }
+
+    // 色度取每个 2x2 块均值的转换。按块先把两行拆成 B、G、R 平面（步长 6 的访问无法向量化），
+    // 结果写入局部缓冲后再按平面或交错格式写出
+    unsigned char plane[6][2 * PIXEL_CHUNK];
+    unsigned char cu[PIXEL_CHUNK], cv[PIXEL_CHUNK];
+    int pairs = width / 2;
+    for (int c0 = 0; c0 < pairs; c0 += PIXEL_CHUNK) {
+        int n = min_int(pairs - c0, PIXEL_CHUNK);
+        const unsigned char *p0 = bgr0 + 6 * c0;
+        const unsigned char *p1 = bgr1 + 6 * c0;
+        for (int i = 0; i < 2 * n; i++) {
+            plane[0][i] = p0[3 * i];
+            plane[1][i] = p0[3 * i + 1];
+            plane[2][i] = p0[3 * i + 2];
+            plane[3][i] = p1[3 * i];
+            plane[4][i] = p1[3 * i + 1];
+            plane[5][i] = p1[3 * i + 2];
+        }
+        for (int i = 0; i < n; i++) {
+            int b = (plane[0][2 * i] + plane[0][2 * i + 1] + plane[3][2 * i] + plane[3][2 * i + 1] + 2) >> 2;
+            int g = (plane[1][2 * i] + plane[1][2 * i + 1] + plane[4][2 * i] + plane[4][2 * i + 1] + 2) >> 2;
+            int r = (plane[2][2 * i] + plane[2][2 * i + 1] + plane[5][2 * i] + plane[5][2 * i + 1] + 2) >> 2;
+            cu[i] = clamp_u8(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            cv[i] = clamp_u8(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+        if (uv_step == 1) {
+            __builtin_memcpy(u + c0, cu, n);
+            __builtin_memcpy(v + c0, cv, n);
+        } else {
+            // NV12：v 紧跟在 u 之后
+            unsigned char *uv = u + 2 * c0;
+            for (int i = 0; i < n; i++) {
+                uv[2 * i] = cu[i];
+                uv[2 * i + 1] = cv[i];
+            }
+        }
+    }
+
+    // 奇数宽度的最后一列只有一对像素
+    if (width & 1) {
+        const unsigned char *p0 = bgr0 + 3 * (width - 1);
+        const unsigned char *p1 = bgr1 + 3 * (width - 1);
+        int b = (p0[0] + p1[0] + 1) / 2, g = (p0[1] + p1[1] + 1) / 2, r = (p0[2] + p1[2] + 1) / 2;
+        u[pairs * uv_step] = clamp_u8(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        v[pairs * uv_step] = clamp_u8(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+}
+
+static int dot_int8(const signed char *a, const signed char *b, int len)
+{
+    int sum = 0;
+    for (int i = 0; i < len; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// 每次取 8 字节异或后计数，各版本都以 -mpopcnt 编译，__builtin_popcountll 即一条 popcnt 指令
+static int hamming_u8(const unsigned char *a, const unsigned char *b, int len)
+{
+    int sum = 0;
+    int i = 0;
+    for (; i + 8 <= len; i += 8) {
+        unsigned long long x, y;
+        __builtin_memcpy(&x, a + i, 8);
+        __builtin_memcpy(&y, b + i, 8);
+        sum += __builtin_popcountll(x ^ y);
+    }
+    for (; i < len; i++) {
+        sum += __builtin_popcount(static_cast<unsigned>(a[i] ^ b[i]));
+    }
+    return sum;
+}
+
+const PixelKernels kernels = {
+    PIXEL_KERNEL_NAME,
+    { row_kernels<1>(), row_kernels<3>(), row_kernels<4>() },
+    bgr_to_yuv420_rows,
+    dot_int8,
+    hamming_u8
+};
+
+} // namespace PIXEL_KERNEL_NAMESPACE
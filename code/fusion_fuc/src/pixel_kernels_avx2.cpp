@@ -0,0 +1,8 @@
+// 像素内核的 AVX2 版本，编译选项见 pixel_kernels.cmake
+#ifndef __AVX2__
+#error "pixel_kernels_avx2.cpp must be compiled with -mavx2"
+#endif
+
+#define PIXEL_KERNEL_NAMESPACE pixel_avx2
+#define PIXEL_KERNEL_NAME "avx2"
+#include "pixel_kernels.inl"
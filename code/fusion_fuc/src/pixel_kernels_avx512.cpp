@@ -0,0 +1,8 @@
+// 像素内核的 AVX-512 版本，编译选项见 pixel_kernels.cmake
+#ifndef __AVX512BW__
+#error "pixel_kernels_avx512.cpp must be compiled with -mavx512bw"
+#endif
+
+#define PIXEL_KERNEL_NAMESPACE pixel_avx512
+#define PIXEL_KERNEL_NAME "avx512"
+#include "pixel_kernels.inl"
@@ -0,0 +1,8 @@
+// 像素内核的 SSE4.2 版本，编译选项见 pixel_kernels.cmake
+#ifndef __SSE4_2__
+#error "pixel_kernels_sse42.cpp must be compiled with -msse4.2"
+#endif
+
+#define PIXEL_KERNEL_NAMESPACE pixel_sse42
+#define PIXEL_KERNEL_NAME "sse4.2"
+#include "pixel_kernels.inl"
@@ -0,0 +1,180 @@
+#include "../include/rotation_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// RANSAC 置信度和迭代上限：两点样本下，内点率 50% 时约 20 次迭代即可
+static const double ROTATION_RANSAC_CONFIDENCE = 0.995;
+static const int ROTATION_RANSAC_MAX_ITERS = 1000;
+
+// 内点重新拟合的轮数，接受旋转所需的最少内点数
+static const int ROTATION_REFINE_ROUNDS = 3;
+static const int ROTATION_MIN_INLIERS = 8;
+
+/**
+ * Builds a pinhole intrinsic matrix with the principal point at the image centre.
+ *
+ * @param focal The focal length in pixels.
+ * @param size The image size.
+ * @return The 3x3 intrinsic matrix K.
+ */
+cv::Matx33d camera_intrinsics(double focal, const cv::Size &size)
+{
+    return cv::Matx33d(focal, 0, size.width * 0.5, 0, focal, size.height * 0.5, 0, 0, 1);
+}
+
+// 像素 -> 单位视线方向
+static cv::Vec3d pixel_to_ray(const cv::Matx33d &k_inv, const cv::Point2f &p)
+{
+    cv::Vec3d ray = k_inv * cv::Vec3d(p.x, p.y, 1.0);
+    return ray / cv::norm(ray);
+}
+
+// 以 a 为第一轴、a 与 b 的法向为第二轴的正交标架（按列存放）
+static bool direction_frame(const cv::Vec3d &a, const cv::Vec3d &b, cv::Matx33d &frame)
+{
+    cv::Vec3d n = a.cross(b);
+    double len = cv::norm(n);
+    // 两个方向几乎共线时不能确定旋转
+    if (len < 1e-6) {
+        return false;
+    }
+    n /= len;
+    cv::Vec3d m = a.cross(n);
+    frame = cv::Matx33d(a[0], n[0], m[0], a[1], n[1], m[1], a[2], n[2], m[2]);
+    return true;
+}
+
+// 两点最小解：两对方向各自的标架对齐，rays1 ≈ R * rays2
+static bool rotation_from_two(const cv::Vec3d &a1, const cv::Vec3d &a2, const cv::Vec3d &b1, const cv::Vec3d &b2,
+                              cv::Matx33d &rotation)
+{
+    cv::Matx33d frame1, frame2;
+    if (!direction_frame(a1, a2, frame1) || !direction_frame(b1, b2, frame2)) {
+        return false;
+    }
+    rotation = frame1 * frame2.t();
+    return true;
+}
+
+// 内点上的最小二乘旋转（Wahba 问题，SVD 闭式解）
+static cv::Matx33d fit_rotation(const std::vector<cv::Vec3d> &rays1, const std::vector<cv::Vec3d> &rays2,
+                                const std::vector<uchar> &mask)
+{
+    cv::Matx33d b = cv::Matx33d::zeros();
+    for (size_t i = 0; i < rays1.size(); i++) {
+        if (mask[i]) {
+            b += rays1[i] * rays2[i].t();
+        }
+    }
+    cv::Mat w, u, vt;
+    cv::SVD::compute(cv::Mat(b), w, u, vt);
+    cv::Matx33d uu(u), vv(vt);
+    double d = cv::determinant(uu * vv) < 0 ? -1.0 : 1.0;
+    return uu * cv::Matx33d::diag(cv::Vec3d(1, 1, d)) * vv;
+}
+
+// 按重投影误差标记内点，返回内点数
+static int mark_inliers(const std::vector<cv::Point2f> &points1, const std::vector<cv::Vec3d> &rays2,
+                        const cv::Matx33d &k1, const cv::Matx33d &rotation, double threshold,
+                        std::vector<uchar> &mask)
+{
+    cv::Matx33d project = k1 * rotation;
+    double threshold2 = threshold * threshold;
+    int count = 0;
+    mask.assign(points1.size(), 0);
+    for (size_t i = 0; i < points1.size(); i++) {
+        cv::Vec3d q = project * rays2[i];
+        if (q[2] <= 0) {
+            continue;
+        }
+        double dx = q[0] / q[2] - points1[i].x;
+        double dy = q[1] / q[2] - points1[i].y;
+        if (dx * dx + dy * dy <= threshold2) {
+            mask[i] = 1;
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Estimates the rotation between two cameras with known intrinsics that share a centre.
+ *
+ * The model has 3 degrees of freedom, so RANSAC draws only two matches per hypothesis
+ * and needs far fewer iterations than an 8-DOF homography. The best hypothesis is refined
+ * by a least-squares fit on its inliers, re-selecting the inliers after each fit.
+ *
+ * @param points1 The points in camera 1 (pixels).
+ * @param points2 The matching points in camera 2 (pixels).
+ * @param k1 The intrinsics of camera 1.
+ * @param k2 The intrinsics of camera 2.
+ * @param threshold The inlier reprojection threshold in camera 1, in pixels.
+ * @param rotation Receives R with ray1 = R * ray2.
+ * @param inlier_mask Receives 1 for every inlier match.
+ * @return True if enough matches agree on a rotation, false otherwise.
+ */
+bool estimate_rotation(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
+                       const cv::Matx33d &k1, const cv::Matx33d &k2, double threshold,
+                       cv::Matx33d &rotation, std::vector<uchar> &inlier_mask)
+{
+    CV_Assert(points1.size() == points2.size());
+    int n = static_cast<int>(points1.size());
+    if (n < ROTATION_MIN_INLIERS) {
+        return false;
+    }
+
+    std::vector<cv::Vec3d> rays1(n), rays2(n);
+    cv::Matx33d k1_inv = k1.inv(), k2_inv = k2.inv();
+    for (int i = 0; i < n; i++) {
+        rays1[i] = pixel_to_ray(k1_inv, points1[i]);
+        rays2[i] = pixel_to_ray(k2_inv, points2[i]);
+    }
+
+    // 固定种子，相同输入得到相同标定
+    cv::RNG rng(0x5eed);
+    int best_count = 0;
+    std::vector<uchar> mask;
+    int iterations = ROTATION_RANSAC_MAX_ITERS;
+    for (int it = 0; it < iterations; it++) {
+        int i = rng.uniform(0, n);
+        int j = rng.uniform(0, n - 1);
+        j += j >= i ? 1 : 0;
+
+        cv::Matx33d hypothesis;
+        if (!rotation_from_two(rays1[i], rays1[j], rays2[i], rays2[j], hypothesis)) {
+            continue;
+        }
+        int count = mark_inliers(points1, rays2, k1, hypothesis, threshold, mask);
+        if (count > best_count) {
+            best_count = count;
+            rotation = hypothesis;
+            inlier_mask = mask;
+
+            // 按当前内点率更新所需迭代次数
+            double ratio = static_cast<double>(count) / n;
+            double miss = 1.0 - ratio * ratio;
+            if (miss <= 0) {
+                break;
+            }
+            double needed = std::log(1.0 - ROTATION_RANSAC_CONFIDENCE) / std::log(miss);
+            iterations = std::min(iterations, static_cast<int>(std::ceil(needed)));
+        }
+    }
+    if (best_count < ROTATION_MIN_INLIERS) {
+        return false;
+    }
+
+    for (int round = 0; round < ROTATION_REFINE_ROUNDS; round++) {
+        cv::Matx33d refined = fit_rotation(rays1, rays2, inlier_mask);
+        int count = mark_inliers(points1, rays2, k1, refined, threshold, mask);
+        if (count < best_count) {
+            break;
+        }
+        rotation = refined;
+        inlier_mask = mask;
+        best_count = count;
+    }
+    return true;
+}
@@ -1,4 +1,17 @@
 #include "../include/stitcher.h"
+#include "../include/anms.h"
+#include "../include/knn_matcher.h"
+#include "../include/compositor.h"
+#include "../include/warp_maps.h"
+#include "../include/rotation_model.h"
+#include "../include/fusion_params.h"
+
+#include <cmath>
+#include <map>
+#include <mutex>
+
+// 每张图像保留的特征点预算，描述子计算量只和预算有关
+static const int FUSION_KEYPOINT_BUDGET = 2000;
 
 //************************************
 // Method:    avframeToCvmat
@@ -37,9 +50,9 @@ cv::Mat avframeToCvmat(const AVFrame *frame) {
         return cv::Mat();
     }
 
-    // 使用 sws_scale 转换图像
-    const uint8_t *srcSlice[1] = { frame->data[0] }; // 创建指向源数据的指针数组
-    int srcLinesizes[1] = { frame->linesize[0] }; // 源数据的步幅
+    // 使用 sws_scale 转换图像，平面格式（如解码得到的 YUV420P）需要传入所有平面
+    const uint8_t *const *srcSlice = frame->data;
+    const int *srcLinesizes = frame->linesize;
 
     // 使用 int 类型的目标步幅
     int dstLinesizes[1] = { static_cast<int>(resMat.step[0]) }; // 使用转换后的步幅
@@ -140,6 +153,144 @@ AVFrame *cvmatToAvframe(const cv::Mat *image, AVFrame *frame) {
     return frame;
 }
 
+// 镜头畸变模型：校正后图像中到镜头中心距离为 rho 的点，在原图中的距离为 rho * lens_radial_ratio(rho)
+static double lens_radial_ratio(double rho)
+{
+    double r = rho * 0.56;
+    double s = 0.9998 - 4.2932e-4 * r + 3.4327e-6 * r * r - 2.8526e-9 * r * r * r + 9.8223e-13 * r * r * r * r;
+    return 1.35 / s;
+}
+
+// lens_radial_ratio(rho) * rho 对 rho 的导数，供牛顿迭代求逆
+static double lens_radial_slope(double rho)
+{
+    double r = rho * 0.56;
+    double s = 0.9998 - 4.2932e-4 * r + 3.4327e-6 * r * r - 2.8526e-9 * r * r * r + 9.8223e-13 * r * r * r * r;
+    double ds = -4.2932e-4 + 2 * 3.4327e-6 * r - 3 * 2.8526e-9 * r * r + 4 * 9.8223e-13 * r * r * r;
+    return 1.35 * (s - r * ds) / (s * s);
+}
+
+// 校正后去掉的黑边：校正图像即原图尺寸下的这一矩形区域
+static cv::Rect lens_crop_rect(const cv::Size &size)
+{
+    int topCropHeight = size.height * 0.126;
+    int bottomCropHeight = size.height * 0.126;
+    int leftCropWidth = size.width * 0.083;
+    int rightCropWidth = size.width * 0.085;
+    return cv::Rect(leftCropWidth, topCropHeight, size.width - leftCropWidth - rightCropWidth,
+                    size.height - topCropHeight - bottomCropHeight);
+}
+
+// 镜头畸变模型和裁剪只和输入尺寸有关：按尺寸缓存校正后裁剪区域的重映射表
+static const WarpMaps &lens_correction_maps(const cv::Size &size)
+{
+    static std::mutex mutex;
+    static std::map<std::pair<int, int>, WarpMaps> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = std::make_pair(size.width, size.height);
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    // 裁剪
+    cv::Rect roi = lens_crop_rect(size);
+
+    // 裁剪区域内每个像素在原图中的位置
+    cv::Point lenscenter(size.width / 2, size.height / 2);
+    cv::Mat map_x(roi.size(), CV_32F), map_y(roi.size(), CV_32F);
+    for (int y = 0; y < roi.height; y++) {
+        float *mx = map_x.ptr<float>(y);
+        float *my = map_y.ptr<float>(y);
+        int row = y + roi.y;
+        for (int x = 0; x < roi.width; x++) {
+            int cols = x + roi.x;
+            double ratio = lens_radial_ratio(std::hypot(cols - lenscenter.x, row - lenscenter.y));
+            cv::Point2f mCorrectPoint((cols - lenscenter.x) * ratio + lenscenter.x, (row - lenscenter.y) * ratio + lenscenter.y);
+
+            // 越界的像素置为无效
+            if (mCorrectPoint.y < 0 || mCorrectPoint.y >= size.height - 1 ||
+                mCorrectPoint.x < 0 || mCorrectPoint.x >= size.width - 1) {
+                mCorrectPoint = cv::Point2f(-1, -1);
+            }
+            mx[x] = mCorrectPoint.x;
+            my[x] = mCorrectPoint.y;
+        }
+    }
+
+    WarpMaps &maps = cache[key];
+    build_warp_maps(map_x, map_y, size, maps);
+    return maps;
+}
+
+/**
+ * Returns the size of a lens-corrected image, that is the crop applied by correct_image().
+ *
+ * @param size The size of the raw frame.
+ * @return The size of the corrected and cropped image.
+ */
+cv::Size lens_corrected_size(const cv::Size &size)
+{
+    return lens_crop_rect(size).size();
+}
+
+/**
+ * Maps raw-frame points into the coordinates of the lens-corrected, cropped image.
+ *
+ * This is the inverse of the per-pixel mapping used by correct_image(). The radial model
+ * is inverted per point with a few Newton steps, so features can be detected on the raw
+ * frame and only their coordinates corrected. Points keep their sub-pixel position; points
+ * that land outside the crop get coordinates outside the corrected image.
+ *
+ * @param points The points in raw-frame coordinates.
+ * @param size The size of the raw frame.
+ * @param undistorted Receives the points in corrected-image coordinates (may alias points).
+ */
+void undistort_points(const std::vector<cv::Point2f> &points, const cv::Size &size,
+                      std::vector<cv::Point2f> &undistorted)
+{
+    cv::Point lenscenter(size.width / 2, size.height / 2);
+    cv::Point crop = lens_crop_rect(size).tl();
+
+    undistorted.resize(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        double dx = points[i].x - lenscenter.x;
+        double dy = points[i].y - lenscenter.y;
+        double target = std::hypot(dx, dy);
+
+        // 求 rho * lens_radial_ratio(rho) = target，模型在画面范围内单调
+        double rho = target / lens_radial_ratio(0);
+        for (int iter = 0; iter < 10 && target > 0; iter++) {
+            double step = (rho * lens_radial_ratio(rho) - target) / lens_radial_slope(rho);
+            rho = std::max(rho - step, 0.0);
+            if (std::abs(step) < 1e-4) {
+                break;
+            }
+        }
+
+        double scale = target > 0 ? rho / target : 1.0;
+        undistorted[i] = cv::Point2f(static_cast<float>(dx * scale + lenscenter.x - crop.x),
+                                     static_cast<float>(dy * scale + lenscenter.y - crop.y));
+    }
+}
+
+/**
+ * Corrects the lens distortion of a BGR image and crops it.
+ *
+ * @param image The raw image (BGR).
+ * @return The corrected and cropped image, or an empty Mat if the input is empty.
+ */
+cv::Mat correct_lens(const cv::Mat &image)
+{
+    cv::Mat corrected;
+    if (!image.empty()) {
+        // 校正和裁剪合并在一张按输入尺寸缓存的重映射表里
+        apply_warp_maps(image, lens_correction_maps(image.size()), corrected);
+    }
+    return corrected;
+}
+
 /**
  * Corrects the lens distortion of an image represented by an AVFrame and crops it.
  *
@@ -160,53 +311,11 @@ bool correct_image(AVFrame *frame_input, AVFrame *frame_output)
     
     // 将 AVFrame 转换为 cv::Mat
     cv::Mat img = avframeToCvmat(frame_input);
-
-    // 创建输出图像
-    cv::Mat drcimg(img.rows, img.cols, CV_8UC3);
-    cv::Point lenscenter(img.cols / 2, img.rows / 2);
-    cv::Point2f src_a, src_b, src_c, src_d;
-    double r, s;
-    cv::Point2f mCorrectPoint;
-    double distance_to_a_x, distance_to_a_y;
-
-    // 校正每个像素
-    for (int row = 0; row < img.rows; row++) {
-        for (int cols = 0; cols < img.cols; cols++) {
-            r = sqrt((row - lenscenter.y) * (row - lenscenter.y) + (cols - lenscenter.x) * (cols - lenscenter.x)) * 0.56;
-            s = 0.9998 - 4.2932 * pow(10, -4) * r + 3.4327 * pow(10, -6) * pow(r, 2) - 2.8526 * pow(10, -9) * pow(r, 3) + 9.8223 * pow(10, -13) * pow(r, 4);mCorrectPoint = cv::Point2f((cols - lenscenter.x) / s * 1.35 + lenscenter.x, (row - lenscenter.y) / s * 1.35 + lenscenter.y);
-
-            // 越界判断
-            if (mCorrectPoint.y < 0 || mCorrectPoint.y >= img.rows - 1 || 
-                mCorrectPoint.x < 0 || mCorrectPoint.x >= img.cols - 1) {
-                continue;
-            }
-            // 计算临近点的坐标
-            src_a = cv::Point2f(static_cast<int>(mCorrectPoint.x), static_cast<int>(mCorrectPoint.y));
-            src_b = cv::Point2f(src_a.x + 1, src_a.y);
-            src_c = cv::Point2f(src_a.x, src_a.y + 1);
-            src_d = cv::Point2f(src_a.x + 1, src_a.y + 1);
-            // 计算新的像素值
-            distance_to_a_x = mCorrectPoint.x - src_a.x;
-            distance_to_a_y = mCorrectPoint.y - src_a.y;
-            for (int channel = 0; channel < 3; channel++) {
-                drcimg.at<cv::Vec3b>(row, cols)[channel] =
-                    img.at<cv::Vec3b>(src_a.y, src_a.x)[channel] * (1 - distance_to_a_x) * (1 - distance_to_a_y) +
-                    img.at<cv::Vec3b>(src_b.y, src_b.x)[channel] * distance_to_a_x * (1 - distance_to_a_y) +
-                    img.at<cv::Vec3b>(src_c.y, src_c.x)[channel] * distance_to_a_y * (1 - distance_to_a_x) +
-                    img.at<cv::Vec3b>(src_d.y, src_d.x)[channel] * distance_to_a_y * distance_to_a_x;
-            }
-        }
+    if (img.empty()) {
+        return false;
     }
 
-    // 裁剪
-    int topCropHeight = drcimg.rows * 0.126;
-    int bottomCropHeight = drcimg.rows * 0.126;
-    int leftCropWidth = drcimg.cols * 0.083;
-    int rightCropWidth = drcimg.cols * 0.085;
-    cv::Rect roi(leftCropWidth, topCropHeight, drcimg.cols - leftCropWidth - rightCropWidth, drcimg.rows - topCropHeight - bottomCropHeight);
-    cv::Mat croppedImg = drcimg(roi);
-
-    cv::imwrite("corrected.jpg", croppedImg);
+    cv::Mat croppedImg = correct_lens(img);
 
     // 转换为 AVFrame
     cvmatToAvframe(&croppedImg, frame_output);
@@ -215,79 +324,158 @@ bool correct_image(AVFrame *frame_input, AVFrame *frame_output)
 }
 
 /**
- * Fuses two AVFrames into a single fused frame.
+ * Updates the per-channel gains of both cameras from overlap statistics.
  *
- * This function takes two input AVFrames, frame1 and frame2, and fuses them into a single output frame, frame_fused.
- * The fusion process is performed by averaging the pixel values of the two input frames.
- * The behavior of the fusion process can be controlled by the options parameter, which specifies whether to apply
- * lens distortion correction before fusion.
+ * Both cameras are pulled towards their common mean in the overlap, so neither one is
+ * treated as the reference. New gains are blended in with weight alpha; the lookup
+ * tables are only rebuilt when the smoothed gains actually move.
  *
- * @param frame1 The first input AVFrame.
- * @param frame2 The second input AVFrame.
- * @param frame_fused The output AVFrame that will contain the fused image.
- * @param is_correct The boolean value will determine whether to perform image correction
- * @return True if the fusion process is successful, false otherwise.
+ * @param calibration The calibration whose gains and tables are updated.
+ * @param overlap1 The img1 overlap region.
+ * @param overlap2 The warped img2 overlap region.
+ * @param mask2 The img2 validity mask of the overlap.
+ * @param step The sampling step.
+ * @param alpha The smoothing weight of the new estimate, 1 replaces the old gains.
  */
-bool image_fusion(AVFrame *frame1, AVFrame *frame2, AVFrame *frame_fused, bool is_correct) {
-    // 检查输入帧有效性
-    if (!frame1 || !frame2 || !frame_fused) {
-        return false;
+static void update_gain(FusionCalibration &calibration, const cv::Mat &overlap1, const cv::Mat &overlap2,
+                        const cv::Mat &mask2, int step, float alpha)
+{
+    cv::Vec3d mean1, mean2;
+    if (overlap_channel_means(overlap1, overlap2, mask2, step, mean1, mean2)) {
+        for (int c = 0; c < 3; c++) {
+            double target = (mean1[c] + mean2[c]) / 2;
+            float g1 = std::clamp(static_cast<float>(target / std::max(mean1[c], 1.0)), FUSION_GAIN_MIN, FUSION_GAIN_MAX);
+            float g2 = std::clamp(static_cast<float>(target / std::max(mean2[c], 1.0)), FUSION_GAIN_MIN, FUSION_GAIN_MAX);
+            calibration.gain1[c] += alpha * (g1 - calibration.gain1[c]);
+            calibration.gain2[c] += alpha * (g2 - calibration.gain2[c]);
+        }
     }
+    int channels = calibration.row_kernels->channels;
+    update_gain_lut(calibration.gain1, channels, calibration.lut_gain1, calibration.gain_lut1);
+    update_gain_lut(calibration.gain2, channels, calibration.lut_gain2, calibration.gain_lut2);
+}
 
-    cv::Mat img1, img2;
-
-    // 根据 is_correct 决定是否进行几何校正
-    if (is_correct) {
-        AVFrame* frame_corrected1 = av_frame_alloc();
-        AVFrame* frame_corrected2 = av_frame_alloc();
+// 每帧刷新增益：只按 FUSION_GAIN_STEP 抽样重叠区。三者经同一个 to_grid 最近邻变换，
+// 抽样网格的第 g 点都取重叠区坐标 FUSION_GAIN_STEP * g 处的像素，样本逐点对齐
+static void refresh_gain(FusionCalibration &calibration, const cv::Mat &img1, const cv::Mat &img2)
+{
+    const cv::Rect &overlap_rect = calibration.overlap_rect;
+    cv::Size grid((overlap_rect.width + FUSION_GAIN_STEP - 1) / FUSION_GAIN_STEP,
+                  (overlap_rect.height + FUSION_GAIN_STEP - 1) / FUSION_GAIN_STEP);
+    double inv_step = 1.0 / FUSION_GAIN_STEP;
+    cv::Mat to_grid = (cv::Mat_<double>(3, 3) << inv_step, 0, 0, 0, inv_step, 0, 0, 0, 1);
+
+    cv::Mat sample1, sample2, sample_mask;
+    cv::warpPerspective(img1(overlap_rect - calibration.img1_rect.tl()), sample1, to_grid, grid, cv::INTER_NEAREST);
+    cv::warpPerspective(calibration.warp_mask(overlap_rect - calibration.warp_rect.tl()), sample_mask, to_grid, grid,
+                        cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar(0));
+    cv::warpPerspective(img2, sample2, to_grid * region_homography(calibration, overlap_rect), grid, cv::INTER_NEAREST);
+
+    update_gain(calibration, sample1, sample2, sample_mask, 1, FUSION_GAIN_ALPHA);
+}
 
-        if (!frame_corrected1 || !frame_corrected2) {
-            return false; 
-        }
+/**
+ * Makes sure the output frame owns a writable buffer of the given size and format.
+ *
+ * The buffer is kept when the frame already matches, so a stable calibration allocates
+ * the output once and every later frame is composited straight into the same planes.
+ *
+ * @param frame The output frame.
+ * @param size The canvas size.
+ * @param format The pixel format.
+ * @return True if the frame is ready to be written, false otherwise.
+ */
+bool prepare_output_frame(AVFrame *frame, const cv::Size &size, AVPixelFormat format)
+{
+    if (frame->buf[0] && frame->width == size.width && frame->height == size.height && frame->format == format) {
+        return av_frame_make_writable(frame) >= 0;
+    }
 
-        // 进行图像几何校正
-        if (!correct_image(frame1, frame_corrected1) || !correct_image(frame2, frame_corrected2)) {
-            av_frame_free(&frame_corrected1);
-            av_frame_free(&frame_corrected2);
-            return false;
-        }
+    av_frame_unref(frame);
+    frame->width = size.width;
+    frame->height = size.height;
+    frame->format = format;
+    return av_frame_get_buffer(frame, 32) >= 0;
+}
 
-        img1 = avframeToCvmat(frame_corrected1);
-        img2 = avframeToCvmat(frame_corrected2);
-        
-        av_frame_free(&frame_corrected1);
-        av_frame_free(&frame_corrected2);
-    } else {
-        // 转换输入帧为 cv::Mat
-        img1 = avframeToCvmat(frame1);
-        img2 = avframeToCvmat(frame2);
+/**
+ * Maps an output pixel format to the pixel layout the canvas is composited in.
+ *
+ * GRAY8, BGR24 and BGRA frames are composited straight into their plane. YUV420P and
+ * NV12 are composited in BGR24 and converted per tile or row pair.
+ *
+ * @param format The output pixel format.
+ * @param layout Receives the canvas layout.
+ * @return True if the format is supported, false otherwise.
+ */
+bool output_pixel_layout(AVPixelFormat format, PixelLayout &layout)
+{
+    switch (format) {
+    case AV_PIX_FMT_GRAY8:
+        layout = PIXEL_LAYOUT_GRAY8;
+        return true;
+    case AV_PIX_FMT_BGR24:
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_NV12:
+        layout = PIXEL_LAYOUT_BGR24;
+        return true;
+    case AV_PIX_FMT_BGRA:
+        layout = PIXEL_LAYOUT_BGRA32;
+        return true;
+    default:
+        std::cerr << "Unsupported output format: " << format << std::endl;
+        return false;
     }
+}
 
-    // 检查图像是否有效
-    if (img1.empty() || img2.empty()) {
-        std::cerr << "One or both input images are empty." << std::endl;
-        return false; // 图像为空，返回失败
+/**
+ * Converts a BGR image to the channel count of the canvas layout.
+ *
+ * @param bgr The BGR image.
+ * @param channels 1 (GRAY8), 3 (BGR24) or 4 (BGRA32).
+ * @return The converted image; bgr itself when it already has that many channels.
+ */
+cv::Mat to_pixel_layout(const cv::Mat &bgr, int channels)
+{
+    if (bgr.empty() || bgr.channels() == channels) {
+        return bgr;
     }
+    cv::Mat image;
+    cv::cvtColor(bgr, image, channels == 1 ? cv::COLOR_BGR2GRAY : cv::COLOR_BGR2BGRA);
+    return image;
+}
 
+/**
+ * Detects ORB features in both images and returns the filtered matches as point pairs.
+ *
+ * @param img1 The first image (BGR).
+ * @param img2 The second image (BGR).
+ * @param points1 Receives the matched img1 points.
+ * @param points2 Receives the corresponding img2 points.
+ * @return True if both images had keypoints, false otherwise.
+ */
+bool match_keypoints(const cv::Mat &img1, const cv::Mat &img2,
+                     std::vector<cv::Point2f> &points1, std::vector<cv::Point2f> &points2) {
     // 创建 ORB 特征检测器
     cv::Ptr<cv::ORB> detector = cv::ORB::create(10000);
     std::vector<cv::KeyPoint> keypoints1, keypoints2;
     cv::Mat descriptors1, descriptors2;
 
-    // 检测特征点和计算描述符
-    detector->detectAndCompute(img1, cv::Mat(), keypoints1, descriptors1);
-    detector->detectAndCompute(img2, cv::Mat(), keypoints2, descriptors2);
+    // 检测特征点，经网格 ANMS 筛选后只对保留的点计算描述符
+    bool detected1 = detect_and_compute_uniform(detector, img1, cv::Mat(), FUSION_KEYPOINT_BUDGET, keypoints1, descriptors1);
+    bool detected2 = detect_and_compute_uniform(detector, img2, cv::Mat(), FUSION_KEYPOINT_BUDGET, keypoints2, descriptors2);
 
     // 如果特征点数量为零，返回失败
-    if (keypoints1.empty() || keypoints2.empty()) {
+    if (!detected1 || !detected2 || keypoints1.empty() || keypoints2.empty()) {
         std::cerr << "No keypoints detected in one or both images." << std::endl;
         return false;
     }
 
-    // 创建暴力匹配器并进行描述子匹配
-    cv::Ptr<cv::BFMatcher> matcher = cv::BFMatcher::create(cv::NORM_HAMMING, true);
+    // 暴力交叉匹配，汉明距离由按 CPU 选择的 popcnt 内核计算
     std::vector<cv::DMatch> matches;
-    matcher->match(descriptors1, descriptors2, matches);
+    if (!hamming_cross_match(descriptors1, descriptors2, matches)) {
+        return false;
+    }
 
     // 筛选出良好的匹配点对
     std::vector<cv::DMatch> good_matches;
@@ -318,91 +506,355 @@ bool image_fusion(AVFrame *frame1, AVFrame *frame2, AVFrame *frame_fused, bool i
     }
 
     // 提取匹配的关键点
-    std::vector<cv::Point2f> points1, points2;
+    points1.clear();
+    points2.clear();
     for (const auto& match : good_matches) {
         points1.push_back(keypoints1[match.queryIdx].pt);
         points2.push_back(keypoints2[match.trainIdx].pt);
     }
+    return true;
+}
 
-    // 使用 RANSAC 算法计算透视变换
-    if (points1.size() < 4 || points2.size() < 4) {
-        std::cerr << "Not enough points for homography calculation." << std::endl;
-        return false; // 点集不足
+/**
+ * Estimates the homography mapping img2 onto img1 from ORB matches.
+ *
+ * With FUSION_MODEL_ROTATION the cameras are assumed to share a centre and to have the
+ * given focal length: a 2-point RANSAC estimates the 3-DOF rotation and the homography is
+ * K1 * R * K2^-1. Otherwise a full 8-DOF homography is fitted with RANSAC.
+ *
+ * @param img1 The reference image (BGR).
+ * @param img2 The image mapped onto img1 (BGR).
+ * @param homography Receives the 3x3 homography, img2 -> img1 coordinates.
+ * @param inliers1 Optional output, the img1 points of the RANSAC inliers.
+ * @param inliers2 Optional output, the matching img2 points.
+ * @param model The motion model to fit.
+ * @param focal The focal length in pixels, required by FUSION_MODEL_ROTATION.
+ * @param raw_input Whether img1 and img2 are raw frames. Features are then detected on
+ *                  them and the matches undistorted with undistort_points(), so the
+ *                  homography and inliers are in correct_image() coordinates.
+ * @return True if a homography was found, false otherwise.
+ */
+bool estimate_homography(const cv::Mat &img1, const cv::Mat &img2, cv::Mat &homography,
+                         std::vector<cv::Point2f> *inliers1, std::vector<cv::Point2f> *inliers2,
+                         FusionMotionModel model, double focal, bool raw_input) {
+    std::vector<cv::Point2f> points1, points2;
+    if (!match_keypoints(img1, img2, points1, points2)) {
+        return false;
     }
 
-    cv::Mat homography = cv::findHomography(points2, points1, cv::RANSAC, 5.0);
-    if (homography.empty()) {
-        std::cerr << "Homography calculation failed." << std::endl;
-        return false; // 透视变换失败
+    // 原图上的匹配只校正坐标，落在裁剪区域外的点对丢弃
+    cv::Size size1 = img1.size();
+    cv::Size size2 = img2.size();
+    if (raw_input) {
+        size1 = lens_corrected_size(img1.size());
+        size2 = lens_corrected_size(img2.size());
+        undistort_points(points1, img1.size(), points1);
+        undistort_points(points2, img2.size(), points2);
+        cv::Rect2f rect1(0, 0, size1.width, size1.height);
+        cv::Rect2f rect2(0, 0, size2.width, size2.height);
+        size_t kept = 0;
+        for (size_t i = 0; i < points1.size(); i++) {
+            if (rect1.contains(points1[i]) && rect2.contains(points2[i])) {
+                points1[kept] = points1[i];
+                points2[kept] = points2[i];
+                kept++;
+            }
+        }
+        points1.resize(kept);
+        points2.resize(kept);
     }
 
-    // 打印变换矩阵
-    std::cout << "Homography Matrix:" << std::endl;
-    std::cout << homography << std::endl;
+    std::vector<uchar> inlier_mask;
+    if (model == FUSION_MODEL_ROTATION) {
+        if (focal <= 0) {
+            std::cerr << "The rotation model needs a focal length." << std::endl;
+            return false;
+        }
+
+        // 只估计旋转：两点最小样本的 RANSAC，再在内点上精化
+        cv::Matx33d k1 = camera_intrinsics(focal, size1);
+        cv::Matx33d k2 = camera_intrinsics(focal, size2);
+        cv::Matx33d rotation;
+        if (!estimate_rotation(points1, points2, k1, k2, 5.0, rotation, inlier_mask)) {
+            std::cerr << "Rotation estimation failed." << std::endl;
+            return false;
+        }
+        homography = cv::Mat(k1 * rotation * k2.inv());
+        homography /= homography.at<double>(2, 2);
+    } else {
+        // 使用 RANSAC 算法计算透视变换
+        if (points1.size() < 4 || points2.size() < 4) {
+            std::cerr << "Not enough points for homography calculation." << std::endl;
+            return false; // 点集不足
+        }
+
+        homography = cv::findHomography(points2, points1, cv::RANSAC, 5.0, inlier_mask);
+        if (homography.empty()) {
+            std::cerr << "Homography calculation failed." << std::endl;
+            return false; // 透视变换失败
+        }
+    }
+
+    // 输出 RANSAC 内点，供全局优化使用
+    if (inliers1 && inliers2) {
+        inliers1->clear();
+        inliers2->clear();
+        for (size_t i = 0; i < inlier_mask.size(); i++) {
+            if (inlier_mask[i]) {
+                inliers1->push_back(points1[i]);
+                inliers2->push_back(points2[i]);
+            }
+        }
+    }
+    return true;
+}
 
+/**
+ * Estimates the homography between two images and derives the canvas geometry.
+ *
+ * The canvas is the tight union of img1 and the projected corners of img2. When img2
+ * projects to negative coordinates the whole canvas is translated so that it starts at
+ * the origin, which moves img1 away from (0, 0).
+ *
+ * @param img1 The reference image, in the layout of calibration.output_format (see
+ *             to_pixel_layout()).
+ * @param img2 The image warped onto img1, same type as img1.
+ * @param calibration Receives the homography and canvas geometry.
+ * @param raw1 Optional raw frame that img1 was lens-corrected from. When both raw frames
+ *             are given, features are detected on them instead of on the corrected images.
+ * @param raw2 Optional raw frame that img2 was lens-corrected from.
+ * @return True if a usable homography was found, false otherwise.
+ */
+bool calibrate_fusion(const cv::Mat &img1, const cv::Mat &img2, FusionCalibration &calibration,
+                      const cv::Mat &raw1, const cv::Mat &raw2) {
+    calibration.valid = false;
 
-    // 拼接图像
-    int dst_width = img1.cols + img2.cols;
-    int dst_height = std::max(img1.rows, img2.rows);
-    cv::Mat dst = cv::Mat::zeros(dst_height, dst_width, img1.type());
+    // 画布的像素布局由输出格式决定，输入须已转换到该布局
+    PixelLayout layout;
+    if (!output_pixel_layout(calibration.output_format, layout)) {
+        return false;
+    }
+    const PixelRowKernels &kernels = pixel_row_kernels(layout);
+    if (img1.type() != CV_8UC(kernels.channels) || img2.type() != img1.type()) {
+        std::cerr << "Input images do not match the " << kernels.channels << "-channel output layout." << std::endl;
+        return false;
+    }
+
+    bool raw_input = !raw1.empty() && !raw2.empty();
+    if (raw_input && (lens_corrected_size(raw1.size()) != img1.size() ||
+                      lens_corrected_size(raw2.size()) != img2.size())) {
+        std::cerr << "Raw frames do not match the corrected images." << std::endl;
+        return false;
+    }
 
-    // 将图像 1 复制到目标图像
-    img1.copyTo(dst(cv::Rect(0, 0, img1.cols, img1.rows)));
+    cv::Mat homography;
+    if (!estimate_homography(raw_input ? raw1 : img1, raw_input ? raw2 : img2, homography, nullptr, nullptr,
+                             calibration.motion_model, calibration.focal, raw_input)) {
+        return false;
+    }
 
-    // 将图像 2 透视变换并复制到目标图像
-    cv::Mat transformed_img2;
-    cv::warpPerspective(img2, transformed_img2, homography, dst.size());
+    // 打印变换矩阵
+    std::cout << "Homography Matrix:" << std::endl;
+    std::cout << homography << std::endl;
 
-    // 自动识别重叠区域
+    // 图像 2 的四个角点变换后的外接矩形
     std::vector<cv::Point2f> corners = {
         cv::Point2f(0, 0),
-        cv::Point2f(img1.cols, 0),
-        cv::Point2f(img1.cols, img1.rows),
-        cv::Point2f(0, img1.rows)
+        cv::Point2f(img2.cols, 0),
+        cv::Point2f(img2.cols, img2.rows),
+        cv::Point2f(0, img2.rows)
     };
 
     std::vector<cv::Point2f> transformed_corners;
     cv::perspectiveTransform(corners, transformed_corners, homography);
-    cv::Rect transformed_rect = cv::boundingRect(transformed_corners);
-    cv::Rect overlap_rect = cv::Rect(0, 0, img1.cols, img1.rows) & transformed_rect;
-
-    // 进行渐入渐出法处理重叠区域
-    for (int y = overlap_rect.y; y < overlap_rect.y + overlap_rect.height; y++) {
-        for (int x = overlap_rect.x; x < overlap_rect.x + overlap_rect.width; x++) {
-            // 计算权重
-            float d1 = static_cast<float>(overlap_rect.x + overlap_rect.width - x) / overlap_rect.width; 
-            float d2 = static_cast<float>(x - overlap_rect.x) / overlap_rect.width;
-
-            // 确保权重在 [0, 1] 之间
-            d1 = std::clamp(d1, 0.0f, 1.0f);
-            d2 = std::clamp(d2, 0.0f, 1.0f);
-
-            // 获取左图和右图的像素
-            cv::Vec3b pixel1 = img1.at<cv::Vec3b>(y, x);
-            cv::Vec3b pixel2 = transformed_img2.at<cv::Vec3b>(y, x);
-
-            // 进行加权平均（逐通道处理）
-            cv::Vec3b blended_pixel;
-            blended_pixel[0] = cv::saturate_cast<uchar>(pixel1[0] * d1 + pixel2[0] * d2);
-            blended_pixel[1] = cv::saturate_cast<uchar>(pixel1[1] * d1 + pixel2[1] * d2);
-            blended_pixel[2] = cv::saturate_cast<uchar>(pixel1[2] * d1 + pixel2[2] * d2);
-
-            // 更新拼接后图像的重叠区域像素
-            dst.at<cv::Vec3b>(y, x) = blended_pixel;
+    cv::Rect projected_rect = cv::boundingRect(transformed_corners);
+
+    // 画布 = 图像 1 与图像 2 投影范围的并集，平移到原点
+    cv::Rect union_rect = cv::Rect(0, 0, img1.cols, img1.rows) | projected_rect;
+    double max_area = FUSION_MAX_CANVAS_RATIO * (img1.total() + img2.total());
+    if (union_rect.area() <= 0 || union_rect.area() > max_area) {
+        std::cerr << "Degenerate homography, canvas size " << union_rect.size() << "." << std::endl;
+        return false;
+    }
+    cv::Point shift = -union_rect.tl();
+
+    calibration.input_size1 = img1.size();
+    calibration.input_size2 = img2.size();
+    calibration.homography = homography;
+    calibration.canvas_size = union_rect.size();
+    calibration.img1_rect = cv::Rect(shift.x, shift.y, img1.cols, img1.rows);
+    calibration.warp_rect = projected_rect + shift;
+    calibration.overlap_rect = calibration.img1_rect & calibration.warp_rect;
+
+    // 图像 2 直接变换到 warp_rect 的局部坐标：先整体平移，再减去 warp_rect 原点
+    cv::Point warp_shift = shift - calibration.warp_rect.tl();
+    cv::Mat offset = (cv::Mat_<double>(3, 3) << 1, 0, warp_shift.x, 0, 1, warp_shift.y, 0, 0, 1);
+    calibration.warp_homography = offset * homography;
+
+    // 图像 2 的有效区域只和几何有关，标定时变换一次
+    cv::Mat full_mask(img2.size(), CV_8UC1, cv::Scalar(255));
+    cv::warpPerspective(full_mask, calibration.warp_mask, calibration.warp_homography,
+                        calibration.warp_rect.size(), cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar(0));
+
+    // 按两幅图中心的左右关系决定接缝哪一侧取图像 2
+    calibration.img2_on_right = (calibration.warp_rect.x + calibration.warp_rect.width / 2) >=
+                                (calibration.img1_rect.x + calibration.img1_rect.width / 2);
+
+    // 在标定帧的重叠区域上用动态规划找接缝，之后每帧只混合接缝附近的窄带
+    const cv::Rect &overlap_rect = calibration.overlap_rect;
+    calibration.seam.clear();
+    calibration.seam_ramp.clear();
+    calibration.seam_band = FUSION_SEAM_BAND;
+    calibration.row_kernels = &kernels;
+    calibration.blend_mask.release();
+    calibration.gain1 = cv::Vec3f(1, 1, 1);
+    calibration.gain2 = cv::Vec3f(1, 1, 1);
+    if (!overlap_rect.empty()) {
+        cv::Rect overlap_in_warp = overlap_rect - calibration.warp_rect.tl();
+        cv::Mat warp_overlap;
+        cv::warpPerspective(img2, warp_overlap, calibration.warp_homography, calibration.warp_rect.size());
+        find_seam(img1(overlap_rect - calibration.img1_rect.tl()), warp_overlap(overlap_in_warp),
+                  calibration.warp_mask(overlap_in_warp), calibration.seam);
+        build_seam_ramp(overlap_rect.width, calibration.seam_band, calibration.img2_on_right, calibration.seam_ramp);
+
+        // 多频段融合的分界即接缝，图像 2 无效的像素归图像 1
+        calibration.blend_mask.create(overlap_rect.size(), CV_8UC1);
+        for (int y = 0; y < overlap_rect.height; y++) {
+            const uchar *valid = calibration.warp_mask.ptr<uchar>(overlap_in_warp.y + y) + overlap_in_warp.x;
+            uchar *mask = calibration.blend_mask.ptr<uchar>(y);
+            for (int x = 0; x < overlap_rect.width; x++) {
+                bool img2_side = calibration.img2_on_right ? x >= calibration.seam[y] : x < calibration.seam[y];
+                mask[x] = (valid[x] && img2_side) ? 255 : 0;
+            }
+        }
+
+        // 用标定帧的重叠区估计初始增益
+        update_gain(calibration, img1(overlap_rect - calibration.img1_rect.tl()), warp_overlap(overlap_in_warp),
+                    calibration.warp_mask(overlap_in_warp), 2, 1.0f);
+    } else {
+        update_gain_lut(calibration.gain1, kernels.channels, calibration.lut_gain1, calibration.gain_lut1);
+        update_gain_lut(calibration.gain2, kernels.channels, calibration.lut_gain2, calibration.gain_lut2);
+    }
+    calibration.pyramid_blender.reset();
+
+    // 图块分类只和几何、接缝有关
+    classify_tiles(calibration);
+
+    std::cout << "Canvas size: " << calibration.canvas_size
+              << ", img1 at " << calibration.img1_rect.tl()
+              << ", img2 at " << calibration.warp_rect
+              << ", pixel kernels: " << pixel_kernels().name << std::endl;
+
+    calibration.valid = true;
+    return true;
+}
+
+/**
+ * Converts an input frame to a BGR image, optionally correcting the lens distortion first.
+ *
+ * @param frame The input frame.
+ * @param is_correct Whether to run correct_image() before the conversion.
+ * @return The BGR image, or an empty Mat on failure.
+ */
+cv::Mat frame_to_image(AVFrame *frame, bool is_correct)
+{
+    // 进行图像几何校正，直接在 Mat 上重映射，不经过中间的 AVFrame
+    cv::Mat image = avframeToCvmat(frame);
+    return is_correct ? correct_lens(image) : image;
+}
+
+/**
+ * Fuses two AVFrames into a single fused frame.
+ *
+ * This function takes two input AVFrames, frame1 and frame2, and fuses them into a single output frame, frame_fused.
+ * The fusion process is performed by averaging the pixel values of the two input frames.
+ * The behavior of the fusion process can be controlled by the options parameter, which specifies whether to apply
+ * lens distortion correction before fusion.
+ *
+ * @param frame1 The first input AVFrame.
+ * @param frame2 The second input AVFrame.
+ * @param frame_fused The output AVFrame that will contain the fused image.
+ * @param is_correct The boolean value will determine whether to perform image correction
+ * @param calibration Optional cached calibration. It is (re)computed when invalid or when the
+ *                    input sizes change, and reused otherwise so the output size stays stable.
+ *                    When null, every call calibrates from scratch.
+ * @return True if the fusion process is successful, false otherwise.
+ */
+bool image_fusion(AVFrame *frame1, AVFrame *frame2, AVFrame *frame_fused, bool is_correct,
+                  FusionCalibration *calibration) {
+    // 检查输入帧有效性
+    if (!frame1 || !frame2 || !frame_fused) {
+        return false;
+    }
+
+    // 没有传入缓存时每次都重新标定
+    FusionCalibration local_calibration;
+    FusionCalibration &calib = calibration ? *calibration : local_calibration;
+
+    // 画布按输出格式的像素布局合成，输入在校正后转换到该布局
+    PixelLayout layout;
+    if (!output_pixel_layout(calib.output_format, layout)) {
+        return false;
+    }
+    const PixelRowKernels &kernels = pixel_row_kernels(layout);
+
+    // 原图保留下来，标定时在原图上检测特征点
+    cv::Mat raw1 = avframeToCvmat(frame1);
+    cv::Mat raw2 = avframeToCvmat(frame2);
+    cv::Mat img1 = to_pixel_layout(is_correct ? correct_lens(raw1) : raw1, kernels.channels);
+    cv::Mat img2 = to_pixel_layout(is_correct ? correct_lens(raw2) : raw2, kernels.channels);
+
+    // 检查图像是否有效
+    if (img1.empty() || img2.empty()) {
+        std::cerr << "One or both input images are empty." << std::endl;
+        return false; // 图像为空，返回失败
+    }
+
+    // 尺寸或输出布局变化时重新标定
+    if (!calib.valid || calib.input_size1 != img1.size() || calib.input_size2 != img2.size() ||
+        calib.row_kernels != &kernels) {
+        if (!calibrate_fusion(img1, img2, calib, is_correct ? raw1 : cv::Mat(), is_correct ? raw2 : cv::Mat())) {
+            return false;
         }
     }
 
-    // 处理右图的非重叠部分
-    cv::Rect right_non_overlap_rect(overlap_rect.x + overlap_rect.width, 0, transformed_img2.cols - overlap_rect.x - overlap_rect.width, transformed_img2.rows);
-    if (right_non_overlap_rect.width > 0 && right_non_overlap_rect.x < dst.cols) {
-        transformed_img2(right_non_overlap_rect).copyTo(dst(right_non_overlap_rect));
+    // 用抽样的重叠区统计平滑刷新增益
+    const cv::Rect &overlap_rect = calib.overlap_rect;
+    if (calib.gain_compensation && !overlap_rect.empty()) {
+        refresh_gain(calib, img1, img2);
     }
 
-    // 保存拼接后的图像
-    cv::imwrite("fused.jpg", dst);
-    
-    // 转换拼接后的图像为 AVFrame
-    cvmatToAvframe(&dst, frame_fused);
+    // 输出帧按画布大小复用缓冲，合成结果直接写入其数据平面
+    if (!prepare_output_frame(frame_fused, calib.canvas_size, calib.output_format)) {
+        std::cerr << "Could not allocate output frame." << std::endl;
+        return false;
+    }
+
+    // 多频段融合：金字塔只覆盖重叠区域，结果由合成时直接覆盖重叠区
+    cv::Mat blended_overlap;
+    if (calib.blend_mode == FUSION_BLEND_MULTIBAND && !overlap_rect.empty()) {
+        if (!calib.pyramid_blender) {
+            calib.pyramid_blender = std::make_shared<PyramidBlender>();
+            calib.pyramid_blender->set_mask(calib.blend_mask);
+        }
+        cv::Mat &overlap1 = calib.overlap_buffer1;
+        cv::Mat &overlap2 = calib.overlap_buffer2;
+        cv::Mat src1 = img1(overlap_rect - calib.img1_rect.tl());
+        cv::warpPerspective(img2, overlap2, region_homography(calib, overlap_rect), overlap_rect.size());
+        if (calib.gain_compensation) {
+            cv::LUT(src1, calib.gain_lut1, overlap1);
+            cv::LUT(overlap2, calib.gain_lut2, overlap2);
+        } else {
+            src1.copyTo(overlap1);
+        }
+        // 图像 2 未覆盖的像素用图像 1 填充，避免黑边经低频层渗入
+        overlap1.copyTo(overlap2, calib.warp_mask(overlap_rect - calib.warp_rect.tl()) == 0);
+        calib.pyramid_blender->blend(overlap1, overlap2, overlap1);
+        blended_overlap = overlap1;
+    }
+
+    // 按图块一次写出最终像素：图像 1、图像 2、接缝混合或空白，YUV 输出在图块内转换
+    composite_tiles(img1, img2, calib, blended_overlap, frame_fused);
 
     return true;
-}
\ No newline at end of file
+}
@@ -0,0 +1,55 @@
+#include "../include/warp_maps.h"
+
+#include <opencv2/imgproc.hpp>
+
+/**
+ * Converts floating-point source coordinates into fixed-point remap tables.
+ *
+ * Coordinates outside the source (for example -1 for points a model rejects) produce
+ * zero in the mask and black in the warped output.
+ *
+ * @param map_x The source x coordinate of every output pixel (CV_32F).
+ * @param map_y The source y coordinate of every output pixel (CV_32F).
+ * @param src_size The size of the images the tables will be applied to.
+ * @param maps Output tables and validity mask.
+ */
+void build_warp_maps(const cv::Mat &map_x, const cv::Mat &map_y, const cv::Size &src_size, WarpMaps &maps)
+{
+    CV_Assert(map_x.type() == CV_32F && map_y.type() == CV_32F && map_x.size() == map_y.size());
+
+    cv::Mat full_mask(src_size, CV_8UC1, cv::Scalar(255));
+    cv::remap(full_mask, maps.mask, map_x, map_y, cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar(0));
+    cv::convertMaps(map_x, map_y, maps.map1, maps.map2, CV_16SC2);
+}
+
+/**
+ * Warps an image through precomputed tables with bilinear interpolation.
+ *
+ * @param src The source image.
+ * @param maps Tables from build_warp_maps().
+ * @param dst The output, maps.size(); reused when it already has that size and type.
+ */
+void apply_warp_maps(const cv::Mat &src, const WarpMaps &maps, cv::Mat &dst)
+{
+    cv::remap(src, dst, maps.map1, maps.map2, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar::all(0));
+}
+
+/**
+ * Warps one row stripe of the output through precomputed tables.
+ *
+ * Lets a caller split several warps into stripes and run them all in one parallel loop;
+ * a remap nested in another parallel_for_ would run single-threaded.
+ *
+ * @param src The source image.
+ * @param maps Tables from build_warp_maps().
+ * @param rows The output rows to write.
+ * @param dst The output, already allocated with maps.size() and the type of src.
+ */
+void apply_warp_maps(const cv::Mat &src, const WarpMaps &maps, const cv::Range &rows, cv::Mat &dst)
+{
+    CV_Assert(dst.size() == maps.size() && dst.type() == src.type());
+
+    cv::Mat stripe = dst.rowRange(rows);
+    cv::remap(src, stripe, maps.map1.rowRange(rows), maps.map2.rowRange(rows), cv::INTER_LINEAR,
+              cv::BORDER_CONSTANT, cv::Scalar::all(0));
+}
@@ -0,0 +1,52 @@
+#include "../include/yuv_convert.h"
+
+#include "../include/pixel_kernels.h"
+
+/**
+ * Converts two BGR rows to YUV 4:2:0 (BT.601, limited range).
+ *
+ * Luma is written for both rows; chroma is the conversion of each 2x2 block's average.
+ * For an odd last row pass bgr1 = bgr0 and y1 = nullptr. With uv_step = 1 the chroma goes
+ * to separate U and V planes (YUV420P); with uv_step = 2 and v = u + 1 it goes to one
+ * interleaved plane (NV12).
+ *
+ * @param bgr0 The first BGR row.
+ * @param bgr1 The second BGR row.
+ * @param width The number of pixels per row, may be odd.
+ * @param y0 The luma output of the first row.
+ * @param y1 The luma output of the second row, or nullptr.
+ * @param u The U output, (width + 1) / 2 samples.
+ * @param v The V output, (width + 1) / 2 samples.
+ * @param uv_step The distance in bytes between consecutive chroma samples, 1 or 2.
+ */
+void bgr_to_yuv420_rows(const uchar *bgr0, const uchar *bgr1, int width,
+                        uchar *y0, uchar *y1, uchar *u, uchar *v, int uv_step)
+{
+    pixel_kernels().bgr_to_yuv420_rows(bgr0, bgr1, width, y0, y1, u, v, uv_step);
+}
+
+/**
+ * Converts two BGR rows and stores them into a YUV420P or NV12 frame.
+ *
+ * @param bgr0 The BGR row landing on frame row y.
+ * @param bgr1 The BGR row landing on frame row y + 1, or nullptr if y is the last row.
+ * @param width The number of pixels per row.
+ * @param x The first frame column, must be even.
+ * @param y The first frame row, must be even.
+ * @param frame The output frame, AV_PIX_FMT_YUV420P or AV_PIX_FMT_NV12.
+ */
+void store_yuv420_rows(const uchar *bgr0, const uchar *bgr1, int width, int x, int y, AVFrame *frame)
+{
+    uchar *y0 = frame->data[0] + static_cast<ptrdiff_t>(y) * frame->linesize[0] + x;
+    uchar *y1 = bgr1 ? y0 + frame->linesize[0] : nullptr;
+    ptrdiff_t cy = y / 2;
+    int cx = x / 2;
+    if (frame->format == AV_PIX_FMT_NV12) {
+        uchar *uv = frame->data[1] + cy * frame->linesize[1] + 2 * cx;
+        bgr_to_yuv420_rows(bgr0, bgr1 ? bgr1 : bgr0, width, y0, y1, uv, uv + 1, 2);
+    } else {
+        uchar *u = frame->data[1] + cy * frame->linesize[1] + cx;
+        uchar *v = frame->data[2] + cy * frame->linesize[2] + cx;
+        bgr_to_yuv420_rows(bgr0, bgr1 ? bgr1 : bgr0, width, y0, y1, u, v, 1);
+    }
+}
@@ -0,0 +1,317 @@
+#include <iostream>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <opencv2/features2d.hpp>
+#include "sift_scale_space.h"
+#include "hessian_detector.h"
+#include "../fusion_fuc/include/knn_matcher.h"
+#include "../fusion_fuc/include/pixel_kernels.h"
+
+// 每个阶段重复计时的次数，取最小值
+#define BENCHMARK_RUNS 3
+// 与 image_fusion() 一致的 RANSAC 重投影阈值
+#define RANSAC_THRESHOLD 5.0
+// Lowe 比值检验阈值
+#define MATCH_RATIO 0.7f
+// Hessian 特征点没有尺度信息，描述时使用的固定邻域直径
+#define HESSIAN_KEYPOINT_SIZE 12.0f
+
+// 一个待测的检测器：detect 只做检测，describe 对给定特征点计算描述子；
+// fused 表示检测和描述在同一遍中完成（describe 为空）
+struct DetectorEntry
+{
+    std::string name;
+    std::function<void(const cv::Mat&, std::vector<cv::KeyPoint>&, cv::Mat&)> detect;
+    std::function<void(const cv::Mat&, std::vector<cv::KeyPoint>&, cv::Mat&)> describe;
+    bool binary;
+};
+
+// 一个检测器在一对图像上的结果
+struct BenchmarkResult
+{
+    double detect_ms;
+    double describe_ms;
+    double match_ms;
+    double ransac_ms;
+    size_t keypoints1;
+    size_t keypoints2;
+    size_t matches;
+    int inliers;
+    double reprojection_error;  // 内点的平均重投影误差（像素）
+    bool homography_found;
+};
+
+// 重复执行 BENCHMARK_RUNS 次，返回最短耗时（毫秒）
+double timeMs(const std::function<void()>& fn)
+{
+    double best = 0;
+    for (int run = 0; run < BENCHMARK_RUNS; run++)
+    {
+        int64 start = cv::getTickCount();
+        fn();
+        double ms = (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+        if (run == 0 || ms < best)
+        {
+            best = ms;
+        }
+    }
+    return best;
+}
+
+std::vector<DetectorEntry> createDetectors()
+{
+    std::vector<DetectorEntry> detectors;
+
+    cv::Ptr<cv::ORB> orb = cv::ORB::create(10000);
+    cv::Ptr<cv::SIFT> sift = cv::SIFT::create();
+
+    // Hessian 检测器只给出位置，用 OpenCV SIFT 描述子描述
+    auto sift_describe = [sift](const cv::Mat& image, std::vector<cv::KeyPoint>& keypoints, cv::Mat& descriptors)
+    {
+        sift->compute(image, keypoints, descriptors);
+    };
+
+    detectors.push_back({ "orb",
+        [orb](const cv::Mat& image, std::vector<cv::KeyPoint>& keypoints, cv::Mat&)
+        {
+            orb->detect(image, keypoints);
+        },
+        [orb](const cv::Mat& image, std::vector<cv::KeyPoint>& keypoints, cv::Mat& descriptors)
+        {
+            orb->compute(image, keypoints, descriptors);
+        },
+        true });
+
+    detectors.push_back({ "opencv_sift",
+        [sift](const cv::Mat& image, std::vector<cv::KeyPoint>& keypoints, cv::Mat&)
+        {
+            sift->detect(image, keypoints);
+        },
+        sift_describe,
+        false });
+
+    // 与 sift_feature_3.cpp 相同的参数
+    detectors.push_back({ "dog_sift",
+        [](const cv::Mat& image, std::vector<cv::KeyPoint>& keypoints, cv::Mat& descriptors)
+        {
+            detectDoGSIFT(image, 0.5, 0.1, 1.6, 640, 3, keypoints, descriptors);
+        },
+        nullptr,
+        false });
+
+    // 与 hessian_feature_2.cpp 相同的参数
+    detectors.push_back({ "hessian_separable",
+        [](const cv::Mat& image, std::vector<cv::KeyPoint>& keypoints, cv::Mat&)
+        {
+            std::vector<cv::Point2f> points = detectHessianFeatures(image, 4.0f, 1.0f, 10);
+            cv::KeyPoint::convert(points, keypoints, HESSIAN_KEYPOINT_SIZE);
+        },
+        sift_describe,
+        false });
+
+    // 与 hessian_feature_3.cpp 相同的参数
+    detectors.push_back({ "hessian_box",
+        [](const cv::Mat& image, std::vector<cv::KeyPoint>& keypoints, cv::Mat&)
+        {
+            keypoints = detectBoxHessianFeatures(image, 0.0004f, 3, 1);
+        },
+        sift_describe,
+        false });
+
+    return detectors;
+}
+
+// 比值检验匹配：二进制描述子用汉明距离暴力匹配，浮点描述子用量化 kNN 匹配器
+void matchDescriptors(const cv::Mat& descriptors1, const cv::Mat& descriptors2, bool binary,
+                      std::vector<cv::DMatch>& matches)
+{
+    matches.clear();
+    if (descriptors1.empty() || descriptors2.empty())
+    {
+        return;
+    }
+
+    if (binary)
+    {
+        cv::BFMatcher matcher(cv::NORM_HAMMING);
+        std::vector<std::vector<cv::DMatch>> knn_matches;
+        matcher.knnMatch(descriptors1, descriptors2, knn_matches, 2);
+        for (const auto& m : knn_matches)
+        {
+            if (m.size() == 2 && m[0].distance < MATCH_RATIO * m[1].distance)
+            {
+                matches.push_back(m[0]);
+            }
+        }
+    }
+    else
+    {
+        QuantizedKnnMatcher matcher;
+        matcher.train(descriptors2);
+        matcher.ratio_match(descriptors1, matches, MATCH_RATIO);
+    }
+}
+
+BenchmarkResult runDetector(const DetectorEntry& detector, const cv::Mat& image1, const cv::Mat& image2)
+{
+    BenchmarkResult result = {};
+    std::vector<cv::KeyPoint> keypoints1, keypoints2;
+    cv::Mat descriptors1, descriptors2;
+
+    result.detect_ms = timeMs([&]()
+    {
+        detector.detect(image1, keypoints1, descriptors1);
+        detector.detect(image2, keypoints2, descriptors2);
+    });
+
+    if (detector.describe)
+    {
+        // compute 会剔除边界上的特征点，每次从检测结果的副本开始
+        std::vector<cv::KeyPoint> detected1 = keypoints1, detected2 = keypoints2;
+        result.describe_ms = timeMs([&]()
+        {
+            keypoints1 = detected1;
+            keypoints2 = detected2;
+            detector.describe(image1, keypoints1, descriptors1);
+            detector.describe(image2, keypoints2, descriptors2);
+        });
+    }
+
+    result.keypoints1 = keypoints1.size();
+    result.keypoints2 = keypoints2.size();
+
+    std::vector<cv::DMatch> matches;
+    result.match_ms = timeMs([&]()
+    {
+        matchDescriptors(descriptors1, descriptors2, detector.binary, matches);
+    });
+    result.matches = matches.size();
+
+    if (matches.size() < 4)
+    {
+        return result;
+    }
+
+    // 与 image_fusion() 相同：把第二幅图变换到第一幅图
+    std::vector<cv::Point2f> points1, points2;
+    for (const auto& m : matches)
+    {
+        points1.push_back(keypoints1[m.queryIdx].pt);
+        points2.push_back(keypoints2[m.trainIdx].pt);
+    }
+
+    cv::Mat homography;
+    std::vector<uchar> inlier_mask;
+    result.ransac_ms = timeMs([&]()
+    {
+        homography = cv::findHomography(points2, points1, cv::RANSAC, RANSAC_THRESHOLD, inlier_mask);
+    });
+    if (homography.empty())
+    {
+        return result;
+    }
+    result.homography_found = true;
+
+    // 内点的平均重投影误差
+    std::vector<cv::Point2f> projected;
+    cv::perspectiveTransform(points2, projected, homography);
+    double error_sum = 0;
+    for (size_t i = 0; i < inlier_mask.size(); i++)
+    {
+        if (inlier_mask[i])
+        {
+            error_sum += cv::norm(projected[i] - points1[i]);
+            result.inliers++;
+        }
+    }
+    if (result.inliers > 0)
+    {
+        result.reprojection_error = error_sum / result.inliers;
+    }
+
+    return result;
+}
+
+void writeResultJson(std::ostream& out, const std::string& name, const BenchmarkResult& r)
+{
+    double inlier_ratio = r.matches > 0 ? static_cast<double>(r.inliers) / r.matches : 0.0;
+    out << "        {\"detector\": \"" << name << "\""
+        << ", \"detect_ms\": " << r.detect_ms
+        << ", \"describe_ms\": " << r.describe_ms
+        << ", \"match_ms\": " << r.match_ms
+        << ", \"ransac_ms\": " << r.ransac_ms
+        << ", \"keypoints1\": " << r.keypoints1
+        << ", \"keypoints2\": " << r.keypoints2
+        << ", \"matches\": " << r.matches
+        << ", \"inliers\": " << r.inliers
+        << ", \"inlier_ratio\": " << inlier_ratio
+        << ", \"reprojection_error\": " << r.reprojection_error
+        << ", \"homography_found\": " << (r.homography_found ? "true" : "false") << "}";
+}
+
+// 用法：FeatureBenchmark [仓库根目录] [输出 JSON 文件]
+// 不指定输出文件时 JSON 写到标准输出，进度信息写到标准错误
+int main(int argc, char** argv)
+{
+    std::string root = argc > 1 ? argv[1] : "../..";
+
+    std::vector<std::pair<std::string, std::string>> pairs = {
+        { root + "/doc/image/l.png", root + "/doc/image/r.png" },
+        { root + "/code/fusion_fuc/img/left_1.jpg", root + "/code/fusion_fuc/img/right_1.jpg" },
+    };
+
+    std::vector<DetectorEntry> detectors = createDetectors();
+
+    std::ostringstream json;
+    // 记录本机选中的像素内核版本，不同机器的结果才能对比
+    json << "{\n  \"runs\": " << BENCHMARK_RUNS << ",\n  \"pixel_kernels\": \"" << pixel_kernels().name
+         << "\",\n  \"pairs\": [\n";
+
+    for (size_t p = 0; p < pairs.size(); p++)
+    {
+        cv::Mat image1 = cv::imread(pairs[p].first, cv::IMREAD_COLOR);
+        cv::Mat image2 = cv::imread(pairs[p].second, cv::IMREAD_COLOR);
+        if (image1.empty() || image2.empty())
+        {
+            std::cerr << "Error: Failed to load " << pairs[p].first << " / " << pairs[p].second << std::endl;
+            return 1;
+        }
+
+        json << "    {\"image1\": \"" << pairs[p].first << "\", \"image2\": \"" << pairs[p].second << "\""
+             << ", \"width\": " << image1.cols << ", \"height\": " << image1.rows << ",\n"
+             << "      \"results\": [\n";
+
+        for (size_t d = 0; d < detectors.size(); d++)
+        {
+            std::cerr << "[" << p + 1 << "/" << pairs.size() << "] " << detectors[d].name << std::endl;
+            BenchmarkResult result = runDetector(detectors[d], image1, image2);
+            writeResultJson(json, detectors[d].name, result);
+            json << (d + 1 < detectors.size() ? ",\n" : "\n");
+        }
+
+        json << "      ]}" << (p + 1 < pairs.size() ? ",\n" : "\n");
+    }
+
+    json << "  ]\n}\n";
+
+    if (argc > 2)
+    {
+        std::ofstream file(argv[2]);
+        if (!file)
+        {
+            std::cerr << "Error: Failed to open " << argv[2] << std::endl;
+            return 1;
+        }
+        file << json.str();
+    }
+    else
+    {
+        std::cout << json.str();
+    }
+
+    return 0;
+}
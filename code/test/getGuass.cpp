@@ -4,6 +4,7 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <map>
+#include "../fusion_fuc/include/gaussian_blur.h"
 
 #define STEP 6
 #define ABS(X) ((X)>0? X:(-(X)))
@@ -30,28 +31,9 @@ std::vector<cv::Mat> computeScaleSpace(const cv::Mat& image, double sigma_min, d
     for (int i = 0; i < num_scales; i++) 
     {
         // cv::GaussianBlur(image, scale_space[i], cv::Size(), sigmas[i], sigmas[i]);
-        double sigma = sigmas[i];
-        int ksize = static_cast<int>(6 * sigma + 1); // 高斯核大小为 6σ + 1
-        ksize = (ksize % 2 == 0) ? ksize + 1 : ksize; // 确保核大小为奇数
-
-        cv::Mat kernel(ksize, ksize, CV_64F);
-        double sum = 0.0;
-        for (int x = -ksize / 2; x <= ksize / 2; x++) 
-        {
-            for (int y = -ksize / 2; y <= ksize / 2; y++) 
-            {
-                double val = std::exp(-((x * x + y * y) / (2.0 * sigma * sigma))) / (2 * M_PI * sigma * sigma);
-                kernel.at<double>(y + ksize / 2, x + ksize / 2) = val;
-                sum += val;
-            }
-        }
-
-        // 归一化高斯核
-        kernel /= sum;
-
-        // 执行高斯卷积
+        // 小 sigma 用缓存的一维核做可分离卷积，大 sigma 用递归滤波
         cv::Mat blurred;
-        cv::filter2D(image, blurred, image.depth(), kernel);
+        gaussian_blur(image, blurred, sigmas[i]);
         scale_space[i] = blurred;
     }
 
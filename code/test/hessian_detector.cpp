@@ -0,0 +1,350 @@
+#include "hessian_detector.h"
+
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+/*
+G(x, y, σ) = g(x) g(y),  g(t) = 1/(√(2π)σ) e-t²/2σ²
+σ²Gxx = σ² g''(x) g(y),  σ²Gyy = σ² g(x) g''(y),  σ²Gxy = σ² g'(x) g'(y)
+*/
+void computeHessianDerivatives(const cv::Mat& gray, float sigma, int kernel_radius,
+                               cv::Mat& fxx, cv::Mat& fyy, cv::Mat& fxy)
+{
+    int ksize = 2 * kernel_radius + 1;
+    cv::Mat g(ksize, 1, CV_32F), g1(ksize, 1, CV_32F), g2(ksize, 1, CV_32F);
+
+    // 构建一维高斯及其一阶、二阶导数核
+    double sigma2 = static_cast<double>(sigma) * sigma;
+    for (int i = -kernel_radius; i <= kernel_radius; i++)
+    {
+        double val = std::exp(-(i * i) / (2.0 * sigma2)) / (std::sqrt(2 * CV_PI) * sigma);
+        g.at<float>(i + kernel_radius) = static_cast<float>(val);
+        g1.at<float>(i + kernel_radius) = static_cast<float>(-i / sigma2 * val);
+        g2.at<float>(i + kernel_radius) = static_cast<float>((i * i / sigma2 - 1.0) / sigma2 * val);
+    }
+
+    // 尺度归一化：乘以 σ²，放在二阶核 / 一阶核上
+    cv::Mat g2n = g2 * sigma2;
+    cv::Mat g1n = g1 * sigma;
+
+    // 每个方向 O(2W+1) 而不是 O((2W+1)²)
+    cv::sepFilter2D(gray, fxx, CV_32F, g2n, g, cv::Point(-1, -1), 0, cv::BORDER_REPLICATE);
+    cv::sepFilter2D(gray, fyy, CV_32F, g, g2n, cv::Point(-1, -1), 0, cv::BORDER_REPLICATE);
+    cv::sepFilter2D(gray, fxy, CV_32F, g1n, g1n, cv::Point(-1, -1), 0, cv::BORDER_REPLICATE);
+}
+
+/*
+H = [fxx fxy]
+    [fxy fyy]
+λ = (fxx + fyy)/2 ± √(((fxx - fyy)/2)² + fxy²)
+*/
+void computeHessianEigenvalues(const cv::Mat& fxx, const cv::Mat& fyy, const cv::Mat& fxy,
+                               cv::Mat& lambda1, cv::Mat& lambda2)
+{
+    CV_Assert(fxx.type() == CV_32F && fyy.size() == fxx.size() && fxy.size() == fxx.size());
+
+    lambda1.create(fxx.size(), CV_32F);
+    lambda2.create(fxx.size(), CV_32F);
+
+    cv::parallel_for_(cv::Range(0, fxx.rows), [&](const cv::Range& range)
+    {
+        for (int y = range.start; y < range.end; y++)
+        {
+            const float* pxx = fxx.ptr<float>(y);
+            const float* pyy = fyy.ptr<float>(y);
+            const float* pxy = fxy.ptr<float>(y);
+            float* l1 = lambda1.ptr<float>(y);
+            float* l2 = lambda2.ptr<float>(y);
+
+            int x = 0;
+#if CV_SIMD
+            cv::v_float32 half = cv::vx_setall_f32(0.5f);
+            for (; x <= fxx.cols - cv::v_float32::nlanes; x += cv::v_float32::nlanes)
+            {
+                cv::v_float32 a = cv::vx_load(pxx + x);
+                cv::v_float32 b = cv::vx_load(pyy + x);
+                cv::v_float32 c = cv::vx_load(pxy + x);
+                cv::v_float32 mean = (a + b) * half;
+                cv::v_float32 diff = (a - b) * half;
+                cv::v_float32 root = cv::v_sqrt(cv::v_muladd(diff, diff, c * c));
+                cv::v_store(l1 + x, mean + root);
+                cv::v_store(l2 + x, mean - root);
+            }
+#endif
+            for (; x < fxx.cols; x++)
+            {
+                float mean = (pxx[x] + pyy[x]) * 0.5f;
+                float diff = (pxx[x] - pyy[x]) * 0.5f;
+                float root = std::sqrt(diff * diff + pxy[x] * pxy[x]);
+                l1[x] = mean + root;
+                l2[x] = mean - root;
+            }
+        }
+    });
+}
+
+std::vector<cv::Point2f> detectHessianFeatures(const cv::Mat& image, float threshold,
+                                               float sigma, int kernel_radius, int nms_radius)
+{
+    std::vector<cv::Point2f> featurePoints;
+    if (image.empty())
+    {
+        return featurePoints;
+    }
+
+    // 转为单通道浮点灰度图
+    cv::Mat gray;
+    if (image.channels() == 3)
+    {
+        cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+    }
+    else
+    {
+        gray = image;
+    }
+    gray.convertTo(gray, CV_32F);
+
+    cv::Mat fxx, fyy, fxy, lambda1, lambda2;
+    computeHessianDerivatives(gray, sigma, kernel_radius, fxx, fyy, fxy);
+    computeHessianEigenvalues(fxx, fyy, fxy, lambda1, lambda2);
+
+    // 两个特征值都大于阈值 <=> 较小的特征值大于阈值，以它作为响应
+    cv::Mat response;
+    cv::threshold(lambda2, response, threshold, 0, cv::THRESH_TOZERO);
+
+    // 非极大值抑制：只保留邻域内响应最大的点
+    cv::Mat local_max;
+    cv::Mat element = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * nms_radius + 1, 2 * nms_radius + 1));
+    cv::dilate(response, local_max, element);
+
+    int border = kernel_radius;
+    for (int h = border; h < response.rows - border; h++)
+    {
+        const float* r = response.ptr<float>(h);
+        const float* m = local_max.ptr<float>(h);
+        for (int w = border; w < response.cols - border; w++)
+        {
+            if (r[w] > 0 && r[w] >= m[w])
+            {
+                featurePoints.push_back(cv::Point2f(w, h));
+            }
+        }
+    }
+
+    return featurePoints;
+}
+
+// 每个倍频程 4 层，第一倍频程滤波器尺寸 9, 15, 21, 27
+#define BOX_LAYERS_PER_OCTAVE 4
+
+// 一层盒子滤波响应图
+struct BoxResponseLayer
+{
+    int filter_size;   // 滤波器尺寸 L
+    int step;          // 采样步长
+    cv::Mat response;  // det(H) 近似值，尺寸为原图 / step
+    cv::Mat laplacian; // 迹的符号，1 为正
+};
+
+// 积分图上任意矩形的像素和：左上角 (row, col)，大小 rows x cols
+static inline int boxIntegral(const cv::Mat& integral, int row, int col, int rows, int cols)
+{
+    const int* top = integral.ptr<int>(row);
+    const int* bottom = integral.ptr<int>(row + rows);
+    return bottom[col + cols] - bottom[col] - top[col + cols] + top[col];
+}
+
+// 计算一层响应的一行
+static void computeBoxResponseRow(const cv::Mat& integral, BoxResponseLayer& layer, int ry, float norm)
+{
+    int filter = layer.filter_size;
+    int b = (filter - 1) / 2;
+    int l = filter / 3;
+    int w = filter;
+    float inverse_area = norm / (w * w);
+
+    float* resp = layer.response.ptr<float>(ry);
+    uchar* lap = layer.laplacian.ptr<uchar>(ry);
+
+    int img_rows = integral.rows - 1;
+    int img_cols = integral.cols - 1;
+    int r = ry * layer.step;
+
+    // 盒子超出图像的位置响应为 0
+    if (r - b < 0 || r + b + 1 > img_rows)
+    {
+        return;
+    }
+
+    for (int rx = 0; rx < layer.response.cols; rx++)
+    {
+        int c = rx * layer.step;
+        if (c - b < 0 || c + b + 1 > img_cols)
+        {
+            continue;
+        }
+
+        // Dxx、Dyy 为三段盒子，Dxy 为四个象限盒子
+        float dxx = static_cast<float>(boxIntegral(integral, r - l + 1, c - b, 2 * l - 1, w)
+                                       - boxIntegral(integral, r - l + 1, c - l / 2, 2 * l - 1, l) * 3);
+        float dyy = static_cast<float>(boxIntegral(integral, r - b, c - l + 1, w, 2 * l - 1)
+                                       - boxIntegral(integral, r - l / 2, c - l + 1, l, 2 * l - 1) * 3);
+        float dxy = static_cast<float>(boxIntegral(integral, r - l, c + 1, l, l)
+                                       + boxIntegral(integral, r + 1, c - l, l, l)
+                                       - boxIntegral(integral, r - l, c - l, l, l)
+                                       - boxIntegral(integral, r + 1, c + 1, l, l));
+        dxx *= inverse_area;
+        dyy *= inverse_area;
+        dxy *= inverse_area;
+
+        // det(H) ≈ Dxx·Dyy - (0.9·Dxy)²
+        resp[rx] = dxx * dyy - 0.81f * dxy * dxy;
+        lap[rx] = (dxx + dyy >= 0) ? 1 : 0;
+    }
+}
+
+// 判断中间层的点是否为 3x3x3 邻域内的最大值，三层尺寸相同
+static bool isBoxExtremum(const BoxResponseLayer& below, const BoxResponseLayer& middle,
+                          const BoxResponseLayer& above, int ry, int rx, float threshold)
+{
+    float candidate = middle.response.at<float>(ry, rx);
+    if (candidate < threshold)
+    {
+        return false;
+    }
+
+    const BoxResponseLayer* layers[3] = { &below, &middle, &above };
+    for (int li = 0; li < 3; li++)
+    {
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            const float* row = layers[li]->response.ptr<float>(ry + dy);
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                if (li == 1 && dy == 0 && dx == 0)
+                {
+                    continue;
+                }
+                if (row[rx + dx] >= candidate)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<cv::KeyPoint> detectBoxHessianFeatures(const cv::Mat& image, float threshold,
+                                                   int num_octaves, int init_step)
+{
+    std::vector<cv::KeyPoint> keypoints;
+    if (image.empty())
+    {
+        return keypoints;
+    }
+
+    cv::Mat gray;
+    if (image.channels() == 3)
+    {
+        cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+    }
+    else
+    {
+        gray = image;
+    }
+    if (gray.depth() != CV_8U)
+    {
+        gray.convertTo(gray, CV_8U);
+    }
+
+    // 积分图：之后任意尺度的盒子求和都是 O(1)
+    cv::Mat integral;
+    cv::integral(gray, integral, CV_32S);
+
+    // 各倍频程滤波器尺寸：9,15,21,27 / 15,27,39,51 / 27,51,75,99 ...
+    std::vector<BoxResponseLayer> layers;
+    for (int o = 0; o < num_octaves; o++)
+    {
+        int step = init_step << o;
+        int base = 3 * ((1 << (o + 1)) + 1);
+        int increment = 6 << o;
+        for (int i = 0; i < BOX_LAYERS_PER_OCTAVE; i++)
+        {
+            BoxResponseLayer layer;
+            layer.filter_size = base + i * increment;
+            layer.step = step;
+            layer.response = cv::Mat::zeros(gray.rows / step, gray.cols / step, CV_32F);
+            layer.laplacian = cv::Mat::zeros(gray.rows / step, gray.cols / step, CV_8U);
+            layers.push_back(layer);
+        }
+    }
+
+    // 像素值归一化到 [0, 1] 的响应尺度，与常用阈值 0.0004 一致
+    float norm = 1.0f / 255.0f;
+
+    // (层, 行) 展平后并行，每个尺度的代价与滤波器尺寸无关
+    std::vector<int> row_offsets(layers.size() + 1, 0);
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        row_offsets[i + 1] = row_offsets[i] + layers[i].response.rows;
+    }
+    cv::parallel_for_(cv::Range(0, row_offsets.back()), [&](const cv::Range& range)
+    {
+        size_t li = 0;
+        for (int idx = range.start; idx < range.end; idx++)
+        {
+            while (idx >= row_offsets[li + 1])
+            {
+                li++;
+            }
+            computeBoxResponseRow(integral, layers[li], idx - row_offsets[li], norm);
+        }
+    });
+
+    // 每个倍频程内对中间两层做尺度空间非极大值抑制
+    std::mutex keypoints_mutex;
+    cv::parallel_for_(cv::Range(0, num_octaves * (BOX_LAYERS_PER_OCTAVE - 2)), [&](const cv::Range& range)
+    {
+        std::vector<cv::KeyPoint> local;
+        for (int idx = range.start; idx < range.end; idx++)
+        {
+            int o = idx / (BOX_LAYERS_PER_OCTAVE - 2);
+            int m = o * BOX_LAYERS_PER_OCTAVE + idx % (BOX_LAYERS_PER_OCTAVE - 2) + 1;
+            const BoxResponseLayer& below = layers[m - 1];
+            const BoxResponseLayer& middle = layers[m];
+            const BoxResponseLayer& above = layers[m + 1];
+
+            // 最大滤波器的边界之外响应无效
+            int border = (above.filter_size + 1) / (2 * above.step) + 1;
+            for (int ry = border; ry < middle.response.rows - border; ry++)
+            {
+                for (int rx = border; rx < middle.response.cols - border; rx++)
+                {
+                    if (isBoxExtremum(below, middle, above, ry, rx, threshold))
+                    {
+                        // SURF 尺度：σ = 1.2 · L / 9
+                        float scale = 1.2f * middle.filter_size / 9.0f;
+                        cv::KeyPoint kp(static_cast<float>(rx * middle.step), static_cast<float>(ry * middle.step),
+                                        2.0f * scale, -1, middle.response.at<float>(ry, rx), o,
+                                        middle.laplacian.at<uchar>(ry, rx));
+                        local.push_back(kp);
+                    }
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(keypoints_mutex);
+        keypoints.insert(keypoints.end(), local.begin(), local.end());
+    });
+
+    // 按响应降序，保证结果与线程调度无关
+    std::sort(keypoints.begin(), keypoints.end(), [](const cv::KeyPoint& a, const cv::KeyPoint& b)
+    {
+        return a.response > b.response;
+    });
+
+    return keypoints;
+}
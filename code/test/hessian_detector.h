@@ -0,0 +1,25 @@
+#ifndef HESSIAN_DETECTOR_H
+#define HESSIAN_DETECTOR_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 用可分离的高斯导数核计算尺度归一化的二阶偏导 σ²Lxx、σ²Lyy、σ²Lxy
+void computeHessianDerivatives(const cv::Mat& gray, float sigma, int kernel_radius,
+                               cv::Mat& fxx, cv::Mat& fyy, cv::Mat& fxy);
+
+// 闭式求解 2x2 Hessian 矩阵的特征值，lambda1 >= lambda2，按行并行、行内向量化
+void computeHessianEigenvalues(const cv::Mat& fxx, const cv::Mat& fyy, const cv::Mat& fxy,
+                               cv::Mat& lambda1, cv::Mat& lambda2);
+
+// Hessian 特征点检测：两个特征值都大于阈值，并在 (2*nms_radius+1)² 邻域内做非极大值抑制
+std::vector<cv::Point2f> detectHessianFeatures(const cv::Mat& image, float threshold,
+                                               float sigma = 1.0f, int kernel_radius = 10,
+                                               int nms_radius = 1);
+
+// SURF 风格的盒子滤波 Hessian 检测：基于积分图，每个尺度每像素代价恒定，
+// 各尺度并行计算响应，并在 3x3x3 尺度空间邻域内做非极大值抑制
+std::vector<cv::KeyPoint> detectBoxHessianFeatures(const cv::Mat& image, float threshold = 0.0004f,
+                                                   int num_octaves = 3, int init_step = 1);
+
+#endif // HESSIAN_DETECTOR_H
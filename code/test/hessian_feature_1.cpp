@@ -4,6 +4,7 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <map>
+#include "hessian_detector.h"
 
 #define STEP 6
 #define ABS(X) ((X)>0? X:(-(X)))
@@ -14,65 +15,8 @@ using namespace cv;
 
 vector<Point2f> findFeaturePoints(Mat& srcImage, float threshold) 
 {
-    vector<Point2f> featurePoints;
-    int width = srcImage.cols;
-    int height = srcImage.rows;
-
-    // 定义高斯核的尺寸和标准差
-    int W = 5;
-    float sigma = 1.0;
-    Mat xxGauKernel(2 * W + 1, 2 * W + 1, CV_32FC1, Scalar::all(0));
-    Mat xyGauKernel(2 * W + 1, 2 * W + 1, CV_32FC1, Scalar::all(0));
-    Mat yyGauKernel(2 * W + 1, 2 * W + 1, CV_32FC1, Scalar::all(0));
-
-    // 构建高斯二阶偏导数模板
-    for (int i = -W; i <= W; i++) 
-    {
-        for (int j = -W; j <= W; j++) 
-        {
-            xxGauKernel.at<float>(i + W, j + W) = (1 - (i * i) / (sigma * sigma)) * exp(-1 * (i * i + j * j) / (2 * sigma * sigma)) * (-1 / (2 * PI * pow(sigma, 4)));
-            yyGauKernel.at<float>(i + W, j + W) = (1 - (j * j) / (sigma * sigma)) * exp(-1 * (i * i + j * j) / (2 * sigma * sigma)) * (-1 / (2 * PI * pow(sigma, 4)));
-            xyGauKernel.at<float>(i + W, j + W) = ((i * j)) * exp(-1 * (i * i + j * j) / (2 * sigma * sigma)) * (1 / (2 * PI * pow(sigma, 6)));
-        }
-    }
-
-    // 对输入图像进行高斯二阶偏导数卷积
-    Mat xxDerivae(height, width, CV_32FC1, Scalar::all(0));
-    Mat yyDerivae(height, width, CV_32FC1, Scalar::all(0));
-    Mat xyDerivae(height, width, CV_32FC1, Scalar::all(0));
-    filter2D(srcImage, xxDerivae, xxDerivae.depth(), xxGauKernel);
-    filter2D(srcImage, yyDerivae, yyDerivae.depth(), yyGauKernel);
-    filter2D(srcImage, xyDerivae, xyDerivae.depth(), xyGauKernel);
-
-    // 遍历输入图像,寻找Hessian矩阵的局部最大值作为特征点
-    for (int h = W; h < height - W; h++) 
-    {
-        for (int w = W; w < width - W; w++) 
-        {
-            float fxx = xxDerivae.at<float>(h, w);
-            float fyy = yyDerivae.at<float>(h, w);
-            float fxy = xyDerivae.at<float>(h, w);
-
-            // 构建Hessian矩阵
-            float myArray[2][2] = { { fxx, fxy }, { fxy, fyy } };
-            Mat Array(2, 2, CV_32FC1, myArray);
-
-            // 计算Hessian矩阵的特征值
-            Mat eValue;
-            Mat eVector;
-            eigen(Array, eValue, eVector);
-
-            // 根据特征值判断是否为局部最大值
-            float a1 = eValue.at<float>(0, 0);
-            float a2 = eValue.at<float>(1, 0);
-            if ((a1 > 0) && (a2 > 0) && (a1 > threshold) && (a2 > threshold)) 
-            {
-                featurePoints.push_back(Point2f(w, h));
-            }
-        }
-    }
-
-    return featurePoints;
+    // 可分离高斯导数卷积 + 闭式特征值 + 非极大值抑制 (W = 5, σ = 1)
+    return detectHessianFeatures(srcImage, threshold, 1.0f, 5);
 }
 
 // 确定特征点方向
@@ -4,6 +4,7 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <map>
+#include "hessian_detector.h"
 
 #define STEP 6
 #define ABS(X) ((X)>0? X:(-(X)))
@@ -12,65 +13,8 @@
 // 寻找特征点
 std::vector<cv::Point2f> findFeaturePoints(cv::Mat& srcImage, float threshold) 
 {
-    std::vector<cv::Point2f> featurePoints;
-    int width = srcImage.cols;
-    int height = srcImage.rows;
-
-    // 定义高斯核的尺寸和标准差
-    int W = 10                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                        ;
-    float sigma = 1.0;
-    cv::Mat xxGauKernel(2 * W + 1, 2 * W + 1, CV_32FC1, cv::Scalar::all(0));
-    cv::Mat xyGauKernel(2 * W + 1, 2 * W + 1, CV_32FC1, cv::Scalar::all(0));
-    cv::Mat yyGauKernel(2 * W + 1, 2 * W + 1, CV_32FC1, cv::Scalar::all(0));
-
-    // 构建高斯二阶偏导数模板
-    for (int i = -W; i <= W; i++) 
-    {
-        for (int j = -W; j <= W; j++) 
-        {
-            xxGauKernel.at<float>(i + W, j + W) = (1 - (i * i) / (sigma * sigma)) * exp(-1 * (i * i + j * j) / (2 * sigma * sigma)) * (-1 / (2 * PI * pow(sigma, 2)));
-            yyGauKernel.at<float>(i + W, j + W) = (1 - (j * j) / (sigma * sigma)) * exp(-1 * (i * i + j * j) / (2 * sigma * sigma)) * (-1 / (2 * PI * pow(sigma, 2)));
-            xyGauKernel.at<float>(i + W, j + W) = ((i * j)) * exp(-1 * (i * i + j * j) / (2 * sigma * sigma)) * (1 / (2 * PI * pow(sigma, 4)));
-        }
-    }
-
-    // 对输入图像进行高斯二阶偏导数卷积
-    cv::Mat xxDerivae(height, width, CV_32FC1, cv::Scalar::all(0));
-    cv::Mat yyDerivae(height, width, CV_32FC1, cv::Scalar::all(0));
-    cv::Mat xyDerivae(height, width, CV_32FC1, cv::Scalar::all(0));
-    cv::filter2D(srcImage, xxDerivae, xxDerivae.depth(), xxGauKernel);
-    cv::filter2D(srcImage, yyDerivae, yyDerivae.depth(), yyGauKernel);
-    cv::filter2D(srcImage, xyDerivae, xyDerivae.depth(), xyGauKernel);
-
-    // 遍历输入图像,寻找Hessian矩阵的局部最大值作为特征点
-    for (int h = W; h < height - W; h++)
-    {
-        for (int w = W; w < width - W; w++) 
-        {
-            float fxx = xxDerivae.at<float>(h, w);
-            float fyy = yyDerivae.at<float>(h, w);
-            float fxy = xyDerivae.at<float>(h, w);
-
-            // 构建Hessian矩阵
-            float myArray[2][2] = { { fxx, fxy }, { fxy, fyy } };
-            cv::Mat Array(2, 2, CV_32FC1, myArray);
-
-            // 计算Hessian矩阵的特征值
-            cv::Mat eValue;
-            cv::Mat eVector;
-            eigen(Array, eValue, eVector);
-
-            // 根据特征值判断是否为局部最大值
-            float a1 = eValue.at<float>(0, 0);
-            float a2 = eValue.at<float>(1, 0);
-            if ((a1 > 0) && (a2 > 0) && (a1 > threshold) && (a2 > threshold))
-            {
-                featurePoints.push_back(cv::Point2f(w, h));
-            }
-        }
-    }
-
-    return featurePoints;
+    // 可分离高斯导数卷积 + 闭式特征值 + 非极大值抑制 (W = 10, σ = 1)
+    return detectHessianFeatures(srcImage, threshold, 1.0f, 10);
 }
 
 // 计算特征点方向
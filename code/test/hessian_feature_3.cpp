@@ -0,0 +1,46 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <opencv2/opencv.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include "hessian_detector.h"
+
+// 绘画特征点，圆的半径对应特征点尺度
+void drawBoxHessianFeatures(cv::Mat& srcImage, std::vector<cv::KeyPoint>& keypoints)
+{
+    cv::Mat colorImage;
+    srcImage.copyTo(colorImage);
+
+    for (const auto& kp : keypoints)
+    {
+        // 亮斑 (迹为正) 用红色，暗斑用蓝色
+        cv::Scalar color = kp.class_id ? cv::Scalar(0, 0, 255) : cv::Scalar(255, 0, 0);
+        cv::circle(colorImage, kp.pt, static_cast<int>(kp.size), color, 1);
+    }
+
+    imwrite("hessian_feature_3_result.png", colorImage);
+}
+
+int main()
+{
+    cv::Mat srcImage = cv::imread("l.png");
+
+    if (srcImage.empty())
+    {
+        std::cout << "图像未被读入";
+        return 0;
+    }
+
+    // 积分图 + 盒子滤波的多尺度 Hessian 检测
+    auto t1 = std::chrono::high_resolution_clock::now();
+    std::vector<cv::KeyPoint> keypoints = detectBoxHessianFeatures(srcImage, 0.0004f, 3, 1);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> fp_ms = t2 - t1;
+    std::cout << "Keypoints: " << keypoints.size() << ", detection time: " << fp_ms.count() << " ms" << std::endl;
+
+    // 描绘特征点
+    drawBoxHessianFeatures(srcImage, keypoints);
+
+    return 0;
+}
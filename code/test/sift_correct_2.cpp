@@ -5,6 +5,11 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/opencv.hpp>
 #include "correct.h"
+#include "../fusion_fuc/include/anms.h"
+#include "../fusion_fuc/include/knn_matcher.h"
+
+// 每张图像保留的特征点预算
+#define KEYPOINT_BUDGET 4000
 
 int main(int argc, char** argv)
 {
@@ -26,11 +31,15 @@ int main(int argc, char** argv)
     // 创建SIFT特征检测器
     cv::Ptr<cv::SIFT> detector = cv::SIFT::create(100000);
 
-    // 检测SIFT关键点和描述子
+    // 检测SIFT关键点，经网格 ANMS 筛选后再计算描述子
     std::vector<cv::KeyPoint> keypoints1, keypoints2;
     cv::Mat descriptors1, descriptors2;
-    detector->detectAndCompute(corrected_img1, cv::Mat(), keypoints1, descriptors1);
-    detector->detectAndCompute(corrected_img2, cv::Mat(), keypoints2, descriptors2);
+    if (!detect_and_compute_uniform(detector, corrected_img1, cv::Mat(), KEYPOINT_BUDGET, keypoints1, descriptors1) ||
+        !detect_and_compute_uniform(detector, corrected_img2, cv::Mat(), KEYPOINT_BUDGET, keypoints2, descriptors2))
+    {
+        std::cerr << "Error: No keypoints detected." << std::endl;
+        return 1;
+    }
 
     // 绘制特征点
     cv::Mat img_arrows1 = corrected_img1.clone();
@@ -56,20 +65,15 @@ int main(int argc, char** argv)
     cv::imwrite("keypoints1.jpg", img_arrows1);
     cv::imwrite("keypoints2.jpg", img_arrows2);
 
-    // 创建暴力匹配器并进行描述子匹配
-    cv::Ptr<cv::BFMatcher> matcher = cv::BFMatcher::create(cv::NORM_L2);
-    std::vector<std::vector<cv::DMatch>> matches;
-    matcher->knnMatch(descriptors1, descriptors2, matches, 2);
-
-    // 筛选出良好的匹配点对
-    std::vector<cv::DMatch> good_matches;  
-    for (size_t i = 0; i < matches.size(); i++)
+    // 用图像2的描述子建立量化索引，k=2 近邻匹配并做 0.7 比值检验
+    QuantizedKnnMatcher matcher;
+    if (!matcher.train(descriptors2))
     {
-        if (matches[i][0].distance < 0.7 * matches[i][1].distance)
-        {
-            good_matches.push_back(matches[i][0]);
-        }
+        std::cerr << "Error: Failed to build descriptor index." << std::endl;
+        return 1;
     }
+    std::vector<cv::DMatch> good_matches;
+    matcher.ratio_match(descriptors1, good_matches, 0.7f);
 
     // 输出成功匹配的特征点数量
     std::cout << "Number of good matches: " << good_matches.size() << std::endl;
@@ -0,0 +1,625 @@
+#include "sift_scale_space.h"
+#include "../fusion_fuc/include/gaussian_blur.h"
+
+#include <opencv2/core/hal/hal.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <deque>
+#include <mutex>
+
+// 输入图像（及每次 2 倍面积下采样后）假定自带的模糊程度
+#define ASSUMED_BLUR 0.5
+// 最小倍频程的短边长度
+#define MIN_OCTAVE_SIZE 16
+
+// 方向直方图的 bin 数、窗口 sigma 系数
+#define ORI_HIST_BINS 36
+#define ORI_SIG_FCTR 1.5f
+// 描述子：4x4 个子区域，每个 8 个方向，子区域宽度为 3σ
+#define DESCR_WIDTH 4
+#define DESCR_HIST_BINS 8
+#define DESCR_SCL_FCTR 3.0f
+#define DESCR_MAG_THR 0.2f
+
+cv::Mat toGrayFloat(const cv::Mat& image)
+{
+    cv::Mat gray;
+    if (image.channels() == 3)
+    {
+        cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+    }
+    else if (image.channels() == 4)
+    {
+        cv::cvtColor(image, gray, cv::COLOR_BGRA2GRAY);
+    }
+    else
+    {
+        gray = image;
+    }
+
+    cv::Mat gray_float;
+    gray.convertTo(gray_float, CV_32F);
+    return gray_float;
+}
+
+int computeNumOctaves(const cv::Size& size, double sigma_min, double sigma_max)
+{
+    // sigma 每翻一倍需要一个倍频程
+    int by_sigma = static_cast<int>(std::ceil(std::log2(sigma_max / sigma_min)));
+
+    // 图像缩小到 MIN_OCTAVE_SIZE 以下就没有意义了
+    int min_dim = std::min(size.width, size.height);
+    int by_size = static_cast<int>(std::floor(std::log2(static_cast<double>(min_dim) / MIN_OCTAVE_SIZE))) + 1;
+
+    return std::max(1, std::min(by_sigma, by_size));
+}
+
+double octaveLevelSigma(const ScaleSpaceOctave& octave, int level)
+{
+    double k = std::pow(2.0, 1.0 / octave.levels);
+    return octave.sigma0 * std::pow(k, level) * std::pow(2.0, octave.octave);
+}
+
+// 统计一组图像占用的字节数
+static size_t residentBytes(const std::deque<cv::Mat>& mats)
+{
+    size_t bytes = 0;
+    for (const auto& m : mats)
+    {
+        bytes += m.total() * m.elemSize();
+    }
+    return bytes;
+}
+
+// 流式构建一个倍频程：从种子图像逐层增量模糊，最多保留三层高斯图像和三层 DoG
+static ScaleSpaceStats streamOctave(const cv::Mat& seed, const ScaleSpaceOctave& octave,
+                                    const DoGLayerCallback& on_layer)
+{
+    ScaleSpaceStats stats = {0, 0};
+    double sigma_min = octave.sigma0;
+    double k = std::pow(2.0, 1.0 / octave.levels);
+
+    std::deque<cv::Mat> gaussians;
+    std::deque<cv::Mat> dogs;
+
+    // 种子图像带有 ASSUMED_BLUR 的模糊，先补足到 sigma0
+    cv::Mat first;
+    double sigma_init = std::sqrt(std::max(sigma_min * sigma_min - ASSUMED_BLUR * ASSUMED_BLUR, 0.01));
+    gaussian_blur(seed, first, sigma_init);
+    gaussians.push_back(first);
+
+    double sigma_prev = sigma_min;
+    for (int s = 1; s < octave.levels + 3; s++)
+    {
+        // L(x, y, kσ) = G(x, y, σ√(k²-1)) * L(x, y, σ)
+        double sigma_total = sigma_min * std::pow(k, s);
+        double sigma_delta = std::sqrt(sigma_total * sigma_total - sigma_prev * sigma_prev);
+        sigma_prev = sigma_total;
+
+        cv::Mat blurred;
+        gaussian_blur(gaussians.back(), blurred, sigma_delta);
+
+        // D(x, y, σ) = L(x, y, kσ) - L(x, y, σ)
+        cv::Mat dog;
+        cv::subtract(blurred, gaussians.back(), dog);
+
+        gaussians.push_back(blurred);
+        dogs.push_back(dog);
+        if (gaussians.size() > 3)
+        {
+            gaussians.pop_front();
+        }
+        if (dogs.size() > 3)
+        {
+            dogs.pop_front();
+        }
+        stats.peak_bytes = std::max(stats.peak_bytes, residentBytes(gaussians) + residentBytes(dogs));
+
+        // 三层 DoG 就绪后立即检测中间层
+        if (dogs.size() == 3)
+        {
+            std::vector<cv::Mat> window(dogs.begin(), dogs.end());
+            on_layer(octave, s - 2, window, gaussians.front());
+            stats.layers_processed++;
+        }
+    }
+
+    return stats;
+}
+
+ScaleSpaceStats streamDifferenceOfGaussian(const cv::Mat& image,
+                                           double sigma_min,
+                                           double sigma_max,
+                                           int levels_per_octave,
+                                           const DoGLayerCallback& on_layer)
+{
+    cv::Mat gray = toGrayFloat(image);
+    int num_octaves = computeNumOctaves(gray.size(), sigma_min, sigma_max);
+
+    // 先生成每个倍频程的下采样种子图像，总计不到 1.34 次全图访问；种子之间没有依赖
+    std::deque<cv::Mat> seeds(num_octaves);
+    seeds[0] = gray;
+    for (int o = 1; o < num_octaves; o++)
+    {
+        cv::resize(seeds[o - 1], seeds[o], cv::Size(seeds[o - 1].cols / 2, seeds[o - 1].rows / 2), 0, 0, cv::INTER_AREA);
+    }
+
+    // 倍频程按顺序流式处理。不在倍频程外层套 parallel_for_：OpenCV 会把嵌套的 parallel_for_
+    // 串行执行，第 0 个倍频程约占 3/4 的工作量，会连同其中的模糊、极值检测和描述子都落在一个线程上；
+    // 逐个倍频程处理时这些步骤各自按行并行，能用满所有核
+    ScaleSpaceStats stats = {0, 0};
+    for (int o = 0; o < num_octaves; o++)
+    {
+        ScaleSpaceOctave octave;
+        octave.octave = o;
+        octave.sigma0 = sigma_min;
+        octave.levels = levels_per_octave;
+        // 常驻内存：本倍频程及之后的种子，加上本倍频程的窗口
+        size_t seed_bytes = residentBytes(seeds);
+        ScaleSpaceStats octave_stats = streamOctave(seeds.front(), octave, on_layer);
+        seeds.pop_front();
+        stats.peak_bytes = std::max(stats.peak_bytes, seed_bytes + octave_stats.peak_bytes);
+        stats.layers_processed += octave_stats.layers_processed;
+    }
+    return stats;
+}
+
+// 剔除不稳定的边缘响应点：Tr(H)² / Det(H) < (r + 1)² / r
+static bool passEdgeTest(const float* const rows[3], int x, float edge_limit)
+{
+    float center = rows[1][x];
+    float dxx = rows[1][x - 1] - 2 * center + rows[1][x + 1];
+    float dyy = rows[0][x] - 2 * center + rows[2][x];
+    float dxy = (rows[2][x + 1] - rows[2][x - 1] - rows[0][x + 1] + rows[0][x - 1]) * 0.25f;
+
+    float trace = dxx + dyy;
+    float det = dxx * dyy - dxy * dxy;
+
+    // 主曲率异号时不是稳定的特征点
+    return det > 0 && trace * trace < edge_limit * det;
+}
+
+// 标量版本的 26 邻域极值检测，用于行尾和无 SIMD 的情况
+static bool isExtremum(const float* rows[3][3], int x, float contrast_threshold)
+{
+    float center = rows[1][1][x];
+    if (std::abs(center) <= contrast_threshold)
+    {
+        return false;
+    }
+
+    bool is_max = true;
+    bool is_min = true;
+    for (int layer = 0; layer < 3 && (is_max || is_min); layer++)
+    {
+        for (int dy = 0; dy < 3; dy++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                if (layer == 1 && dy == 1 && dx == 0)
+                {
+                    continue;
+                }
+                float v = rows[layer][dy][x + dx];
+                is_max = is_max && center > v;
+                is_min = is_min && center < v;
+            }
+        }
+    }
+    return is_max || is_min;
+}
+
+// 检测一行内的极值点
+static void findRowExtrema(const float* rows[3][3], int cols, int layer, int y,
+                           float contrast_threshold, float edge_limit,
+                           std::vector<cv::Point3i>& extrema)
+{
+    int x = 1;
+#if CV_SIMD
+    const int lanes = cv::v_float32::nlanes;
+    cv::v_float32 v_threshold = cv::vx_setall_f32(contrast_threshold);
+    for (; x <= cols - 1 - lanes; x += lanes)
+    {
+        cv::v_float32 center = cv::vx_load(rows[1][1] + x);
+
+        // 对比度阈值：整组都不满足时直接跳过
+        cv::v_float32 candidate = cv::v_abs(center) > v_threshold;
+        if (!cv::v_check_any(candidate))
+        {
+            continue;
+        }
+
+        // 先比较同层 8 邻域
+        cv::v_float32 n_max = cv::v_max(cv::vx_load(rows[1][1] + x - 1), cv::vx_load(rows[1][1] + x + 1));
+        cv::v_float32 n_min = cv::v_min(cv::vx_load(rows[1][1] + x - 1), cv::vx_load(rows[1][1] + x + 1));
+        for (int dy = 0; dy < 3; dy += 2)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                cv::v_float32 v = cv::vx_load(rows[1][dy] + x + dx);
+                n_max = cv::v_max(n_max, v);
+                n_min = cv::v_min(n_min, v);
+            }
+        }
+        cv::v_float32 is_extrema = candidate & ((center > n_max) | (center < n_min));
+        if (!cv::v_check_any(is_extrema))
+        {
+            continue;
+        }
+
+        // 再比较上下两层各 9 个邻域，每层之后都可以提前退出
+        bool any = true;
+        for (int layer_idx = 0; layer_idx < 3 && any; layer_idx += 2)
+        {
+            for (int dy = 0; dy < 3; dy++)
+            {
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    cv::v_float32 v = cv::vx_load(rows[layer_idx][dy] + x + dx);
+                    n_max = cv::v_max(n_max, v);
+                    n_min = cv::v_min(n_min, v);
+                }
+            }
+            is_extrema = is_extrema & ((center > n_max) | (center < n_min));
+            any = cv::v_check_any(is_extrema);
+        }
+        if (!any)
+        {
+            continue;
+        }
+
+        // 只对通过的通道做边缘检验
+        int mask = cv::v_signmask(is_extrema);
+        for (int lane = 0; lane < lanes; lane++)
+        {
+            if ((mask >> lane) & 1)
+            {
+                if (passEdgeTest(rows[1], x + lane, edge_limit))
+                {
+                    extrema.emplace_back(layer, y, x + lane);
+                }
+            }
+        }
+    }
+#endif
+    for (; x < cols - 1; x++)
+    {
+        if (isExtremum(rows, x, contrast_threshold) && passEdgeTest(rows[1], x, edge_limit))
+        {
+            extrema.emplace_back(layer, y, x);
+        }
+    }
+}
+
+std::vector<cv::Point3i> findScaleSpaceExtrema(const std::vector<cv::Mat>& dog,
+                                               float contrast_threshold,
+                                               float edge_ratio)
+{
+    std::vector<cv::Point3i> extrema;
+    if (dog.size() < 3 || dog[0].type() != CV_32F || dog[0].rows < 3 || dog[0].cols < 3)
+    {
+        return extrema;
+    }
+
+    int num_layers = static_cast<int>(dog.size()) - 2;
+    int rows = dog[0].rows;
+    int cols = dog[0].cols;
+    float edge_limit = (edge_ratio + 1) * (edge_ratio + 1) / edge_ratio;
+    std::mutex extrema_mutex;
+
+    // (层, 行) 展平后并行，每行互不依赖
+    cv::parallel_for_(cv::Range(0, num_layers * (rows - 2)), [&](const cv::Range& range)
+    {
+        std::vector<cv::Point3i> local;
+        for (int idx = range.start; idx < range.end; idx++)
+        {
+            int layer = idx / (rows - 2) + 1;
+            int y = idx % (rows - 2) + 1;
+
+            const float* row_ptrs[3][3];
+            for (int l = 0; l < 3; l++)
+            {
+                for (int dy = 0; dy < 3; dy++)
+                {
+                    row_ptrs[l][dy] = dog[layer - 1 + l].ptr<float>(y - 1 + dy);
+                }
+            }
+            findRowExtrema(row_ptrs, cols, layer, y, contrast_threshold, edge_limit, local);
+        }
+
+        std::lock_guard<std::mutex> lock(extrema_mutex);
+        extrema.insert(extrema.end(), local.begin(), local.end());
+    });
+
+    // 并行收集的顺序不确定，按 (层, 行, 列) 排序保证结果稳定
+    std::sort(extrema.begin(), extrema.end(), [](const cv::Point3i& a, const cv::Point3i& b)
+    {
+        if (a.x != b.x) return a.x < b.x;
+        if (a.y != b.y) return a.y < b.y;
+        return a.z < b.z;
+    });
+
+    return extrema;
+}
+
+void computeGradientMaps(const cv::Mat& gaussian, GradientMaps& maps)
+{
+    CV_Assert(gaussian.type() == CV_32F);
+
+    int rows = gaussian.rows;
+    int cols = gaussian.cols;
+    maps.magnitude.create(rows, cols, CV_32F);
+    maps.orientation.create(rows, cols, CV_32F);
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range)
+    {
+        std::vector<float> dx(cols), dy(cols);
+        for (int y = range.start; y < range.end; y++)
+        {
+            const float* prev = gaussian.ptr<float>(std::max(y - 1, 0));
+            const float* cur = gaussian.ptr<float>(y);
+            const float* next = gaussian.ptr<float>(std::min(y + 1, rows - 1));
+
+            // 中心差分，边界列单独处理，内部循环可自动向量化
+            dx[0] = cur[std::min(1, cols - 1)] - cur[0];
+            dx[cols - 1] = cur[cols - 1] - cur[std::max(cols - 2, 0)];
+            for (int x = 1; x < cols - 1; x++)
+            {
+                dx[x] = cur[x + 1] - cur[x - 1];
+            }
+            for (int x = 0; x < cols; x++)
+            {
+                dy[x] = next[x] - prev[x];
+            }
+
+            // OpenCV HAL 中的向量化模值和快速 atan2
+            cv::hal::magnitude32f(dx.data(), dy.data(), maps.magnitude.ptr<float>(y), cols);
+            cv::hal::fastAtan32f(dy.data(), dx.data(), maps.orientation.ptr<float>(y), cols, true);
+        }
+    });
+}
+
+// 根据梯度方向分布构建特征点方向直方图，返回主方向（度）
+static float dominantOrientation(const GradientMaps& maps, int y, int x, float sigma)
+{
+    float histogram[ORI_HIST_BINS] = { 0 };
+
+    float s = ORI_SIG_FCTR * sigma;
+    int radius = cvRound(3 * s);
+    float exp_scale = -1.0f / (2.0f * s * s);
+
+    for (int dy = -radius; dy <= radius; dy++)
+    {
+        int yy = y + dy;
+        if (yy < 0 || yy >= maps.magnitude.rows)
+        {
+            continue;
+        }
+        const float* mag = maps.magnitude.ptr<float>(yy);
+        const float* ori = maps.orientation.ptr<float>(yy);
+        for (int dx = -radius; dx <= radius; dx++)
+        {
+            int xx = x + dx;
+            if (xx < 0 || xx >= maps.magnitude.cols)
+            {
+                continue;
+            }
+            float weight = std::exp((dx * dx + dy * dy) * exp_scale);
+            int bin = cvRound(ori[xx] * (ORI_HIST_BINS / 360.0f));
+            if (bin >= ORI_HIST_BINS)
+            {
+                bin -= ORI_HIST_BINS;
+            }
+            histogram[bin] += weight * mag[xx];
+        }
+    }
+
+    // 找到直方图中的峰值,作为特征点的主方向
+    int max_bin = 0;
+    for (int i = 1; i < ORI_HIST_BINS; i++)
+    {
+        if (histogram[i] > histogram[max_bin])
+        {
+            max_bin = i;
+        }
+    }
+    return max_bin * (360.0f / ORI_HIST_BINS);
+}
+
+// 4x4x8 的 SIFT 描述子，三线性插值分配到子区域和方向 bin
+static void computeDescriptor(const GradientMaps& maps, int y, int x, float angle, float sigma, float* dst)
+{
+    const int d = DESCR_WIDTH;
+    const int n = DESCR_HIST_BINS;
+    int rows = maps.magnitude.rows;
+    int cols = maps.magnitude.cols;
+
+    // 旋转到主方向
+    float angle_rad = angle * static_cast<float>(CV_PI / 180.0);
+    float hist_width = DESCR_SCL_FCTR * sigma;
+    float cos_t = std::cos(-angle_rad) / hist_width;
+    float sin_t = std::sin(-angle_rad) / hist_width;
+    float bins_per_deg = n / 360.0f;
+    float exp_scale = -1.0f / (d * d * 0.5f);
+    int radius = cvRound(hist_width * 1.4142135623730951f * (d + 1) * 0.5f);
+    radius = std::min(radius, static_cast<int>(std::sqrt(static_cast<double>(rows) * rows + static_cast<double>(cols) * cols)));
+
+    float hist[(DESCR_WIDTH + 2) * (DESCR_WIDTH + 2) * (DESCR_HIST_BINS + 2)] = { 0 };
+
+    for (int i = -radius; i <= radius; i++)
+    {
+        int r = y + i;
+        if (r <= 0 || r >= rows - 1)
+        {
+            continue;
+        }
+        const float* mag_row = maps.magnitude.ptr<float>(r);
+        const float* ori_row = maps.orientation.ptr<float>(r);
+        for (int j = -radius; j <= radius; j++)
+        {
+            int c = x + j;
+            float c_rot = j * cos_t - i * sin_t;
+            float r_rot = j * sin_t + i * cos_t;
+            float rbin = r_rot + d / 2 - 0.5f;
+            float cbin = c_rot + d / 2 - 0.5f;
+            if (rbin <= -1 || rbin >= d || cbin <= -1 || cbin >= d || c <= 0 || c >= cols - 1)
+            {
+                continue;
+            }
+
+            float mag = mag_row[c] * std::exp((c_rot * c_rot + r_rot * r_rot) * exp_scale);
+            float obin = (ori_row[c] - angle) * bins_per_deg;
+
+            int r0 = cvFloor(rbin);
+            int c0 = cvFloor(cbin);
+            int o0 = cvFloor(obin);
+            rbin -= r0;
+            cbin -= c0;
+            obin -= o0;
+            if (o0 < 0) o0 += n;
+            if (o0 >= n) o0 -= n;
+
+            float v_r1 = mag * rbin, v_r0 = mag - v_r1;
+            float v_rc11 = v_r1 * cbin, v_rc10 = v_r1 - v_rc11;
+            float v_rc01 = v_r0 * cbin, v_rc00 = v_r0 - v_rc01;
+            float v_rco111 = v_rc11 * obin, v_rco110 = v_rc11 - v_rco111;
+            float v_rco101 = v_rc10 * obin, v_rco100 = v_rc10 - v_rco101;
+            float v_rco011 = v_rc01 * obin, v_rco010 = v_rc01 - v_rco011;
+            float v_rco001 = v_rc00 * obin, v_rco000 = v_rc00 - v_rco001;
+
+            int idx = ((r0 + 1) * (d + 2) + c0 + 1) * (n + 2) + o0;
+            hist[idx] += v_rco000;
+            hist[idx + 1] += v_rco001;
+            hist[idx + (n + 2)] += v_rco010;
+            hist[idx + (n + 3)] += v_rco011;
+            hist[idx + (d + 2) * (n + 2)] += v_rco100;
+            hist[idx + (d + 2) * (n + 2) + 1] += v_rco101;
+            hist[idx + (d + 3) * (n + 2)] += v_rco110;
+            hist[idx + (d + 3) * (n + 2) + 1] += v_rco111;
+        }
+    }
+
+    // 方向 bin 首尾循环，拷贝到输出
+    for (int i = 0; i < d; i++)
+    {
+        for (int j = 0; j < d; j++)
+        {
+            int idx = ((i + 1) * (d + 2) + (j + 1)) * (n + 2);
+            hist[idx] += hist[idx + n];
+            hist[idx + 1] += hist[idx + n + 1];
+            for (int k = 0; k < n; k++)
+            {
+                dst[(i * d + j) * n + k] = hist[idx + k];
+            }
+        }
+    }
+
+    // 归一化、截断大于 0.2 的分量后再归一化，缩放到 0~255
+    int len = d * d * n;
+    float nrm2 = 0;
+    for (int k = 0; k < len; k++)
+    {
+        nrm2 += dst[k] * dst[k];
+    }
+    float thr = std::sqrt(nrm2) * DESCR_MAG_THR;
+    nrm2 = 0;
+    for (int k = 0; k < len; k++)
+    {
+        dst[k] = std::min(dst[k], thr);
+        nrm2 += dst[k] * dst[k];
+    }
+    float scale = 512.0f / std::max(std::sqrt(nrm2), FLT_EPSILON);
+    for (int k = 0; k < len; k++)
+    {
+        dst[k] = std::min(dst[k] * scale, 255.0f);
+    }
+}
+
+void computeOrientationsAndDescriptors(const GradientMaps& maps,
+                                       const std::vector<cv::Point3i>& extrema,
+                                       float sigma,
+                                       std::vector<cv::KeyPoint>& keypoints,
+                                       cv::Mat& descriptors)
+{
+    int count = static_cast<int>(extrema.size());
+    keypoints.resize(count);
+    descriptors.create(count, DESCR_WIDTH * DESCR_WIDTH * DESCR_HIST_BINS, CV_32F);
+
+    // 特征点之间互不依赖，直接并行
+    cv::parallel_for_(cv::Range(0, count), [&](const cv::Range& range)
+    {
+        for (int i = range.start; i < range.end; i++)
+        {
+            int y = extrema[i].y;
+            int x = extrema[i].z;
+            float angle = dominantOrientation(maps, y, x, sigma);
+            computeDescriptor(maps, y, x, angle, sigma, descriptors.ptr<float>(i));
+            keypoints[i] = cv::KeyPoint(static_cast<float>(x), static_cast<float>(y), 2 * sigma, angle);
+        }
+    });
+}
+
+void detectDoGSIFT(const cv::Mat& image,
+                   double contrast_threshold,
+                   double edge_threshold,
+                   double sigma_min,
+                   double sigma_max,
+                   int levels_per_octave,
+                   std::vector<cv::KeyPoint>& keypoints,
+                   cv::Mat& descriptors,
+                   ScaleSpaceStats* stats)
+{
+    keypoints.clear();
+
+    std::vector<cv::Mat> level_descriptors;
+
+    // 流式构建尺度空间，每完成一层 DoG 就在三层窗口内检测中间层
+    ScaleSpaceStats stream_stats = streamDifferenceOfGaussian(image, sigma_min, sigma_max, levels_per_octave,
+        [&](const ScaleSpaceOctave& octave, int level, const std::vector<cv::Mat>& dog, const cv::Mat& gaussian)
+    {
+        // 26 邻域极值检测，同时剔除不稳定的边缘响应点
+        std::vector<cv::Point3i> extrema = findScaleSpaceExtrema(dog, static_cast<float>(contrast_threshold),
+                                                                 static_cast<float>(edge_threshold));
+        if (extrema.empty())
+        {
+            return;
+        }
+
+        // 本层梯度图只算一次，所有特征点共享
+        GradientMaps maps;
+        computeGradientMaps(gaussian, maps);
+
+        float sigma = static_cast<float>(octave.sigma0 * std::pow(2.0, static_cast<double>(level) / octave.levels));
+        std::vector<cv::KeyPoint> level_keypoints;
+        cv::Mat level_desc;
+        computeOrientationsAndDescriptors(maps, extrema, sigma, level_keypoints, level_desc);
+
+        // 坐标和尺度换算回原图
+        float octave_scale = static_cast<float>(1 << octave.octave);
+        for (auto& kp : level_keypoints)
+        {
+            kp.pt *= octave_scale;
+            kp.size *= octave_scale;
+            kp.octave = octave.octave;
+            keypoints.push_back(kp);
+        }
+        level_descriptors.push_back(level_desc);
+    });
+
+    if (level_descriptors.empty())
+    {
+        descriptors.release();
+    }
+    else
+    {
+        cv::vconcat(level_descriptors, descriptors);
+    }
+
+    if (stats)
+    {
+        *stats = stream_stats;
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef SIFT_SCALE_SPACE_H
+#define SIFT_SCALE_SPACE_H
+
+#include <opencv2/opencv.hpp>
+#include <functional>
+#include <vector>
+
+// 一个倍频程的尺度参数，每个倍频程共 S + 3 层高斯图像
+struct ScaleSpaceOctave
+{
+    int octave;      // 倍频程序号，分辨率为原图的 1/2^octave
+    double sigma0;   // 第一层在本倍频程像素单位下的 sigma
+    int levels;      // 每个倍频程的尺度间隔数 S
+};
+
+// 流式尺度空间的内存统计
+struct ScaleSpaceStats
+{
+    size_t peak_bytes;     // 常驻图像的峰值内存
+    int layers_processed;  // 已完成极值检测的 DoG 层数
+};
+
+// 每完成一层 DoG 就回调一次：dog_window 为相邻的三层 DoG，中间层即待检测层，
+// gaussian 为中间层对应的高斯图像，level 为中间层在倍频程内的序号。
+// 回调在调用线程中按倍频程、层序依次执行
+typedef std::function<void(const ScaleSpaceOctave& octave,
+                           int level,
+                           const std::vector<cv::Mat>& dog_window,
+                           const cv::Mat& gaussian)> DoGLayerCallback;
+
+// 一层高斯图像的梯度幅值和方向图（SoA，CV_32F，方向为 [0, 360) 度）
+struct GradientMaps
+{
+    cv::Mat magnitude;
+    cv::Mat orientation;
+};
+
+// 转为单通道 CV_32F 灰度图（取值范围保持 0~255）
+cv::Mat toGrayFloat(const cv::Mat& image);
+
+// 根据 sigma 范围和图像尺寸确定倍频程数量
+int computeNumOctaves(const cv::Size& size, double sigma_min, double sigma_max);
+
+// 第 level 层相对原图的绝对 sigma
+double octaveLevelSigma(const ScaleSpaceOctave& octave, int level);
+
+// 流式构建 DoG 尺度空间：各倍频程的种子由原图下采样，倍频程逐个处理、内部各步骤按行并行，倍频程内逐层增量模糊，
+// 只保留三层相邻 DoG 常驻内存，每完成一层就回调检测
+ScaleSpaceStats streamDifferenceOfGaussian(const cv::Mat& image,
+                                           double sigma_min,
+                                           double sigma_max,
+                                           int levels_per_octave,
+                                           const DoGLayerCallback& on_layer);
+
+// 在 DoG 序列的中间各层做 3x3x3 的 26 邻域极值检测，并融合 Hessian 边缘响应检验，
+// 返回 (层, y, x)；按 (层, 行) 并行
+std::vector<cv::Point3i> findScaleSpaceExtrema(const std::vector<cv::Mat>& dog,
+                                               float contrast_threshold,
+                                               float edge_ratio);
+
+// 每层只计算一次梯度幅值和方向，行内使用向量化的 atan2 近似
+void computeGradientMaps(const cv::Mat& gaussian, GradientMaps& maps);
+
+// 从梯度图批量计算一层内所有极值点的主方向和 128 维描述子，按特征点并行；
+// sigma 为该层在倍频程像素单位下的尺度，keypoints 坐标为倍频程坐标
+void computeOrientationsAndDescriptors(const GradientMaps& maps,
+                                       const std::vector<cv::Point3i>& extrema,
+                                       float sigma,
+                                       std::vector<cv::KeyPoint>& keypoints,
+                                       cv::Mat& descriptors);
+
+// 自实现的 DoG SIFT：流式尺度空间 + 26 邻域极值 + 批量方向和描述子
+void detectDoGSIFT(const cv::Mat& image,
+                   double contrast_threshold,
+                   double edge_threshold,
+                   double sigma_min,
+                   double sigma_max,
+                   int levels_per_octave,
+                   std::vector<cv::KeyPoint>& keypoints,
+                   cv::Mat& descriptors,
+                   ScaleSpaceStats* stats = nullptr);
+
+#endif // SIFT_SCALE_SPACE_H
@@ -7,6 +7,7 @@
 #include <opencv2/opencv.hpp>
 #include <chrono>
 #include "correct_frame.h" 
+#include "../fusion_fuc/include/knn_matcher.h"
 
 int main(int argc, char** argv) 
 {
@@ -34,6 +35,10 @@ int main(int argc, char** argv)
     // 创建SIFT特征检测器
     cv::Ptr<cv::SIFT> detector = cv::SIFT::create();
 
+    // 每次标定都用当前帧重建图像 2 的索引：两帧取自同一时刻，周期性标定才能跟上
+    // 画面和相机 2 的变化；只训练一次的索引只适用于机位和画面都不变的场合
+    QuantizedKnnMatcher matcher;
+
     int frame_count = 0;
     cv::Mat homography;
 
@@ -81,12 +86,14 @@ int main(int argc, char** argv)
             detector->detectAndCompute(frame1_roi, cv::Mat(), keypoints1, descriptors1);
             detector->detectAndCompute(frame2_roi, cv::Mat(), keypoints2, descriptors2);
 
-            // 创建基于FLANN的描述子匹配器
-            cv::Ptr<cv::DescriptorMatcher> matcher = cv::DescriptorMatcher::create(cv::DescriptorMatcher::FLANNBASED);
-
-            // 进行匹配
+            // 重新建立图像2的量化索引，比值检验筛选匹配
+            if (!matcher.train(descriptors2))
+            {
+                std::cerr << "Failed to build descriptor index." << std::endl;
+                return 1;
+            }
             std::vector<cv::DMatch> matches;
-            matcher->match(descriptors1, descriptors2, matches);
+            matcher.ratio_match(descriptors1, matches, 0.7f);
 
             // 提取匹配的关键点
             std::vector<cv::Point2f> points1, points2;
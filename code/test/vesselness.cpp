@@ -0,0 +1,147 @@
+#include "vesselness.h"
+#include "hessian_detector.h"
+
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+#include <cmath>
+
+VesselnessFilter::VesselnessFilter(const std::vector<float>& sigmas, int tile_size, cv::Size morph_size)
+    : sigmas_(sigmas), tile_size_(std::max(tile_size, 16))
+{
+    if (sigmas_.empty())
+    {
+        sigmas_.push_back(1.0f);
+    }
+
+    // 核半径取 5σ，σ = 1 时与原来的 W = 5 一致
+    filter_halo_ = 0;
+    for (float sigma : sigmas_)
+    {
+        int radius = std::max(1, static_cast<int>(std::ceil(5 * sigma)));
+        radii_.push_back(radius);
+        filter_halo_ = std::max(filter_halo_, radius);
+    }
+
+    // 闭运算 = 先膨胀再腐蚀，需要两倍结构元素半径的边缘
+    morph_element_ = cv::getStructuringElement(cv::MORPH_RECT, morph_size);
+    morph_halo_ = 2 * std::max(morph_size.width, morph_size.height);
+}
+
+// 一行的增强响应：λ1 > 0 且 |λ1| > 1 + |λ2| 时取 (|λ1| - |λ2|)^4，与已有尺度取最大
+static void vesselnessRow(const float* pxx, const float* pyy, const float* pxy, float* out, int len)
+{
+    int x = 0;
+#if CV_SIMD
+    cv::v_float32 half = cv::vx_setall_f32(0.5f);
+    cv::v_float32 one = cv::vx_setall_f32(1.0f);
+    cv::v_float32 zero = cv::vx_setzero_f32();
+    for (; x <= len - cv::v_float32::nlanes; x += cv::v_float32::nlanes)
+    {
+        cv::v_float32 a = cv::vx_load(pxx + x);
+        cv::v_float32 b = cv::vx_load(pyy + x);
+        cv::v_float32 c = cv::vx_load(pxy + x);
+        cv::v_float32 mean = (a + b) * half;
+        cv::v_float32 diff = (a - b) * half;
+        cv::v_float32 root = cv::v_sqrt(cv::v_muladd(diff, diff, c * c));
+        cv::v_float32 l1 = mean + root;
+        cv::v_float32 l2 = mean - root;
+
+        cv::v_float32 abs1 = cv::v_abs(l1);
+        cv::v_float32 abs2 = cv::v_abs(l2);
+        cv::v_float32 mask = (l1 > zero) & (abs1 > one + abs2);
+        cv::v_float32 d = abs1 - abs2;
+        cv::v_float32 d2 = d * d;
+        cv::v_float32 r = cv::v_select(mask, d2 * d2, zero);
+        cv::v_store(out + x, cv::v_max(cv::vx_load(out + x), r));
+    }
+#endif
+    for (; x < len; x++)
+    {
+        float mean = (pxx[x] + pyy[x]) * 0.5f;
+        float diff = (pxx[x] - pyy[x]) * 0.5f;
+        float root = std::sqrt(diff * diff + pxy[x] * pxy[x]);
+        float l1 = mean + root;
+        float l2 = mean - root;
+        if (l1 > 0 && std::abs(l1) > 1 + std::abs(l2))
+        {
+            float d = std::abs(l1) - std::abs(l2);
+            out[x] = std::max(out[x], d * d * d * d);
+        }
+    }
+}
+
+void VesselnessFilter::processTile(const cv::Mat& frame, const cv::Rect& tile, cv::Mat& output) const
+{
+    cv::Rect image_rect(0, 0, frame.cols, frame.rows);
+
+    // 响应区域 = 图块 + 形态学边缘；读取区域再加上导数核边缘
+    cv::Rect response_rect(tile.x - morph_halo_, tile.y - morph_halo_,
+                           tile.width + 2 * morph_halo_, tile.height + 2 * morph_halo_);
+    response_rect &= image_rect;
+    int halo = filter_halo_;
+    cv::Rect read_rect(response_rect.x - halo, response_rect.y - halo,
+                       response_rect.width + 2 * halo, response_rect.height + 2 * halo);
+    read_rect &= image_rect;
+
+    // 灰度化只处理图块自己的读取区域
+    cv::Mat gray;
+    if (frame.channels() == 3)
+    {
+        cv::cvtColor(frame(read_rect), gray, cv::COLOR_BGR2GRAY);
+    }
+    else
+    {
+        gray = frame(read_rect);
+    }
+    gray.convertTo(gray, CV_32F);
+
+    // 响应区域在读取缓冲区中的位置
+    cv::Rect inner(response_rect.x - read_rect.x, response_rect.y - read_rect.y,
+                   response_rect.width, response_rect.height);
+
+    // 多尺度取最大
+    cv::Mat response = cv::Mat::zeros(response_rect.size(), CV_32F);
+    cv::Mat fxx, fyy, fxy;
+    for (size_t s = 0; s < sigmas_.size(); s++)
+    {
+        computeHessianDerivatives(gray, sigmas_[s], radii_[s], fxx, fyy, fxy);
+        for (int y = 0; y < inner.height; y++)
+        {
+            vesselnessRow(fxx.ptr<float>(inner.y + y) + inner.x,
+                          fyy.ptr<float>(inner.y + y) + inner.x,
+                          fxy.ptr<float>(inner.y + y) + inner.x,
+                          response.ptr<float>(y), inner.width);
+        }
+    }
+
+    // 饱和转换到 8 位后做闭运算，只写回图块本身
+    cv::Mat response_u8;
+    response.convertTo(response_u8, CV_8U);
+    cv::morphologyEx(response_u8, response_u8, cv::MORPH_CLOSE, morph_element_);
+
+    cv::Rect tile_in_response(tile.x - response_rect.x, tile.y - response_rect.y, tile.width, tile.height);
+    response_u8(tile_in_response).copyTo(output(tile));
+}
+
+void VesselnessFilter::apply(const cv::Mat& frame, cv::Mat& output) const
+{
+    CV_Assert(!frame.empty() && (frame.channels() == 1 || frame.channels() == 3));
+
+    output.create(frame.size(), CV_8UC1);
+
+    int tiles_x = (frame.cols + tile_size_ - 1) / tile_size_;
+    int tiles_y = (frame.rows + tile_size_ - 1) / tile_size_;
+
+    // 图块之间只读共享输入、写不重叠的输出，直接并行
+    cv::parallel_for_(cv::Range(0, tiles_x * tiles_y), [&](const cv::Range& range)
+    {
+        for (int idx = range.start; idx < range.end; idx++)
+        {
+            int tx = idx % tiles_x;
+            int ty = idx / tiles_x;
+            cv::Rect tile(tx * tile_size_, ty * tile_size_, tile_size_, tile_size_);
+            tile &= cv::Rect(0, 0, frame.cols, frame.rows);
+            processTile(frame, tile, output);
+        }
+    });
+}
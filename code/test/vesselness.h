@@ -0,0 +1,31 @@
+#ifndef VESSELNESS_H
+#define VESSELNESS_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// 基于 Hessian 特征值的线状结构增强，按图块流式处理：
+// 每个图块依次完成灰度化、可分离导数、闭式特征值、多尺度取最大和形态学闭运算，
+// 中间结果只存在于图块缓冲区中，适合逐帧处理视频
+class VesselnessFilter
+{
+public:
+    explicit VesselnessFilter(const std::vector<float>& sigmas,
+                              int tile_size = 64,
+                              cv::Size morph_size = cv::Size(3, 2));
+
+    // 输入 BGR 或灰度帧，输出 CV_8UC1 增强图像
+    void apply(const cv::Mat& frame, cv::Mat& output) const;
+
+private:
+    void processTile(const cv::Mat& frame, const cv::Rect& tile, cv::Mat& output) const;
+
+    std::vector<float> sigmas_;
+    std::vector<int> radii_;   // 每个尺度的导数核半径
+    int tile_size_;
+    int morph_halo_;           // 形态学闭运算需要的边缘宽度
+    int filter_halo_;          // 导数卷积需要的边缘宽度
+    cv::Mat morph_element_;
+};
+
+#endif // VESSELNESS_H
@@ -8,6 +8,7 @@ extern "C" {
 }
 
 #include <map>
+#include <vector>
 #include <queue>
 #include <memory>
 #include <utility>
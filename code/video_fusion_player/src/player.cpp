@@ -58,19 +58,25 @@ static void render_frame(SDL_Texture *texture, AVFrame *frame, int frameRate) {
 // Thread function to handle SDL events and rendering
 static void sdl_render_thread(std::shared_ptr<Task> task, SDL_Texture *texture, int frameRate) {
     SDL_Event event;
-    auto fused_frame_queue = task->get_queue_frame_fused();
 
     while (!quit) {
         // Render frames from fused queue
-        if (!fused_frame_queue->empty()) {
-            AVFrame frame = fused_frame_queue->front();
-            fused_frame_queue->pop();
-
-            texture = SDL_CreateTexture(renderer, 
-                                SDL_PIXELFORMAT_IYUV, 
-                                SDL_TEXTUREACCESS_STREAMING, 
-                                frame.width, 
-                                frame.height);
+        AVFrame *frame = task->pop_frame_fused();
+        if (frame) {
+            // The fused frame is YUV420P, uploaded plane by plane without conversion;
+            // the texture is only recreated when the canvas size changes
+            int tex_w = 0, tex_h = 0;
+            if (texture) {
+                SDL_QueryTexture(texture, NULL, NULL, &tex_w, &tex_h);
+            }
+            if (!texture || tex_w != frame->width || tex_h != frame->height) {
+                if (texture) SDL_DestroyTexture(texture);
+                texture = SDL_CreateTexture(renderer, 
+                                    SDL_PIXELFORMAT_IYUV, 
+                                    SDL_TEXTUREACCESS_STREAMING, 
+                                    frame->width, 
+                                    frame->height);
+            }
                     
             if (!texture) {
                 av_log(NULL, AV_LOG_ERROR, "Failed to create texture: %s\n", SDL_GetError());
@@ -80,7 +86,8 @@ static void sdl_render_thread(std::shared_ptr<Task> task, SDL_Texture *texture,
                 quit = true;
             }
 
-            render_frame(texture, &frame, frameRate); // Assuming 30 FPS for now
+            render_frame(texture, frame, frameRate); // Assuming 30 FPS for now
+            av_frame_free(&frame);
         }
 
         // Poll for SDL events
@@ -127,9 +134,13 @@ int main(int argc, char *argv[])
         exit(-1);
     }
 
-    std::shared_ptr<Task> task = std::make_shared<Task>(2);
-    auto sc_0 = std::make_shared<StreamContext>(0, argv[1], task);
-    auto sc_1 = std::make_shared<StreamContext>(1, argv[2], task);
+    // One stream per camera, in rig order
+    int num_cameras = argc - 1;
+    std::shared_ptr<Task> task = std::make_shared<Task>(num_cameras);
+    std::vector<std::shared_ptr<StreamContext>> streams;
+    for (int i = 0; i < num_cameras; i++) {
+        streams.push_back(std::make_shared<StreamContext>(i, argv[i + 1], task));
+    }
     
     // Init SDL
     if (SDL_Init(SDL_INIT_VIDEO)){
@@ -148,18 +159,21 @@ int main(int argc, char *argv[])
     }   
     renderer = SDL_CreateRenderer(win, -1, 0);
 
-    int frameRate = sc_0->stream->r_frame_rate.num / sc_1->stream->r_frame_rate.den;
+    int frameRate = streams[0]->stream->r_frame_rate.num / streams[0]->stream->r_frame_rate.den;
     
-    // Launch decoding threads for both video streams
-    std::thread decode_thread_1(&StreamContext::decode_loop, sc_0);
-    std::thread decode_thread_2(&StreamContext::decode_loop, sc_1);
+    // Launch one decoding thread per video stream
+    std::vector<std::thread> decode_threads;
+    for (auto &sc : streams) {
+        decode_threads.emplace_back(&StreamContext::decode_loop, sc);
+    }
     // Start the rendering thread with parameters (task and texture)
     std::thread render_thread(sdl_render_thread, task, texture, frameRate);
     // Handle events on the main thread
     // sdl_event_thread();
     // Wait for decoding threads to finish
-    decode_thread_1.join();
-    decode_thread_2.join();
+    for (auto &t : decode_threads) {
+        t.join();
+    }
 
 
     // sdl_render_thread(task, texture, frameRate);
@@ -2,20 +2,25 @@
 #define TASK_HPP
 
 #include "common.h"
+#include "../../fusion_fuc/include/stitcher.h"
+#include "../../fusion_fuc/include/panorama.h"
 
 class Task {
 public:
-    Task(int nums) {
+    Task(int nums) : nums_(nums) {
         /* init queue_map_ */
         for (int i = 0; i < nums; i++) {
-            std::shared_ptr<std::queue<AVFrame>> tmp_queue = 
-                std::make_shared<std::queue<AVFrame>>();
+            std::shared_ptr<std::queue<AVFrame *>> tmp_queue = 
+                std::make_shared<std::queue<AVFrame *>>();
             queue_map_.insert(
-                std::pair<int, std::shared_ptr<std::queue<AVFrame>>>(
+                std::pair<int, std::shared_ptr<std::queue<AVFrame *>>>(
                     i, tmp_queue));
         }
-        queue_frame_fused_ = std::make_shared<std::queue<AVFrame>>();
-        av_log(NULL, AV_LOG_INFO, "Task init! %p\n", this);
+        queue_frame_fused_ = std::make_shared<std::queue<AVFrame *>>();
+        // The renderer uploads the fused frame as IYUV, so composite straight into YUV420P
+        calibration_.output_format = AV_PIX_FMT_YUV420P;
+        panorama_calibration_.output_format = AV_PIX_FMT_YUV420P;
+        av_log(NULL, AV_LOG_INFO, "Task init! %p, pixel kernels: %s\n", this, pixel_kernels().name);
         // Start the frame processing thread
         worker_thread_ = std::thread(&Task::run, this);
     }
@@ -28,6 +33,12 @@ public:
         if (worker_thread_.joinable()) {
             worker_thread_.join(); 
         }
+        // Frames nobody took are owned by the queues
+        for (auto &entry : queue_map_) {
+            free_frames(*entry.second);
+        }
+        std::lock_guard<std::mutex> lock(fused_mutex_);
+        free_frames(*queue_frame_fused_);
     }
     bool fill_queue(int id, AVFrame* frame) {
         if (!frame) {
@@ -38,7 +49,13 @@ public:
             if (queue_map_.find(id) == queue_map_.end()) {
                 return false;
             }
-            queue_map_[id]->push(*frame);
+            // The decoder reuses its frame, so queue a new reference owned by the queue;
+            // run() frees it
+            AVFrame *ref = av_frame_clone(frame);
+            if (!ref) {
+                return false;
+            }
+            queue_map_[id]->push(ref);
         }
         cv_.notify_one();
         return true;
@@ -48,8 +65,12 @@ public:
         if (queue_map_[id]->empty()) {
             return false;
         }
-        *frame = queue_map_[id]->front();
+        // Hand the queued reference over to the caller's frame
+        AVFrame *queued = queue_map_[id]->front();
         queue_map_[id]->pop();
+        av_frame_unref(frame);
+        av_frame_move_ref(frame, queued);
+        av_frame_free(&queued);
         return true;
     }
     bool copyFrame(AVFrame* oldFrame, AVFrame* newFrame)
@@ -110,51 +131,82 @@ public:
     // bool image_fusion(AVFrame *frame1, AVFrame *frame2, AVFrame *frame_fused, bool is_correct) {}
 
     void run() {
-        AVFrame* frame1 = av_frame_alloc();
-        AVFrame* frame2 = av_frame_alloc();
+        std::vector<AVFrame *> inputs(nums_);
         AVFrame* frame_fused = av_frame_alloc();
 
         while (!quit) {
             std::unique_lock<std::mutex> lock(mutex_);
 
-            // Add null-checks for the queues before accessing them
-            if (queue_map_[0] == nullptr || queue_map_[1] == nullptr) {
-                av_log(NULL, AV_LOG_ERROR, "Queue map not initialized! %p\n", this);
-                return; 
-            }
-
-            // Wait until both queues have frames or until stop_ is set
-            cv_.wait(lock, [&] { return (!queue_map_[0]->empty() && !queue_map_[1]->empty()) || stop_; });
+            // Wait until every camera has a frame or until stop_ is set
+            cv_.wait(lock, [&] { return all_queues_ready() || stop_; });
 
             if (stop_) break;
 
-            // Get frames from both queues
-            if (!queue_map_[0]->empty() && !queue_map_[1]->empty()) {
-                *frame1 = queue_map_[0]->front();
-                queue_map_[0]->pop();
-                *frame2 = queue_map_[1]->front();
-                queue_map_[1]->pop();
+            // Take one frame from each camera
+            for (int i = 0; i < nums_; i++) {
+                inputs[i] = queue_map_[i]->front();
+                queue_map_[i]->pop();
+            }
+            lock.unlock();
 
-                // Perform image fusion
-                if (image_fusion(frame1, frame2, frame_fused)) {
-                    queue_frame_fused_->push(*frame_fused);
+            // Two cameras use the tiled two-image path, larger rigs the panorama stitcher;
+            // both reuse their calibration between frames
+            bool fused = nums_ == 2
+                ? image_fusion(inputs[0], inputs[1], frame_fused, false, &calibration_)
+                : panorama_fusion(inputs, frame_fused, false, &panorama_calibration_);
+            if (fused) {
+                // Move the result into a frame owned by the queue, so the next fusion gets
+                // a new buffer instead of overwriting a frame still waiting to be rendered;
+                // the renderer frees it
+                AVFrame *out = av_frame_alloc();
+                if (out) {
+                    av_frame_move_ref(out, frame_fused);
+                    std::lock_guard<std::mutex> fused_lock(fused_mutex_);
+                    queue_frame_fused_->push(out);
                 }
             }
+            for (int i = 0; i < nums_; i++) {
+                av_frame_free(&inputs[i]);
+            }
         }
-        // Clean up   
-        // if (frame1) av_frame_free(&frame1);
-        // if (frame2) av_frame_free(&frame2);
-        // if (frame_fused) av_frame_free(&frame_fused);
+        av_frame_free(&frame_fused);
     }
-    std::shared_ptr<std::queue<AVFrame>> get_queue_frame_fused() {
-        return queue_frame_fused_;
+    // Takes the oldest fused frame, or returns nullptr; the caller frees it with av_frame_free
+    AVFrame *pop_frame_fused() {
+        std::lock_guard<std::mutex> lock(fused_mutex_);
+        if (queue_frame_fused_->empty()) {
+            return nullptr;
+        }
+        AVFrame *frame = queue_frame_fused_->front();
+        queue_frame_fused_->pop();
+        return frame;
     }
 private:
-    std::map<int, std::shared_ptr<std::queue<AVFrame>>> queue_map_;
-    std::shared_ptr<std::queue<AVFrame>> queue_frame_fused_;
+    static void free_frames(std::queue<AVFrame *> &queue) {
+        while (!queue.empty()) {
+            AVFrame *frame = queue.front();
+            queue.pop();
+            av_frame_free(&frame);
+        }
+    }
+    bool all_queues_ready() {
+        for (int i = 0; i < nums_; i++) {
+            if (queue_map_[i]->empty()) {
+                return false;
+            }
+        }
+        return nums_ > 0;
+    }
+
+    int nums_;
+    std::map<int, std::shared_ptr<std::queue<AVFrame *>>> queue_map_;
+    std::shared_ptr<std::queue<AVFrame *>> queue_frame_fused_;
+    std::mutex fused_mutex_;  // queue_frame_fused_ is filled by run() and drained by the render thread
     std::mutex mutex_;
     std::condition_variable cv_;
     std::thread worker_thread_;
     bool stop_ = false;
+    FusionCalibration calibration_;
+    PanoramaCalibration panorama_calibration_;
 };
 #endif
\ No newline at end of file